@@ -9,6 +9,9 @@
 #include <fstream>
 #include <chrono>
 #include <random>
+#include <thread>
+#include <functional>
+#include <queue>
 
 using namespace uvm_sim;
 
@@ -23,6 +26,7 @@ struct BenchmarkResult
     uint64_t total_time_us;
     double throughput_pages_per_sec;
     double fault_rate_per_second;
+    double avg_submit_ns = 0; // producer-side cost per migration job, for the submission benchmarks
 };
 
 BenchmarkResult bench_random_page_access(size_t working_set_size, size_t num_accesses,
@@ -114,6 +118,7 @@ BenchmarkResult bench_sequential_access(size_t working_set_size, size_t num_pass
     config.gpu_memory = 4UL * 1024 * 1024 * 1024;
     config.replacement_policy = PageReplacementPolicy::LRU;
     config.use_gpu_simulator = true;
+    config.enable_prefetch = true;
     config.log_level = LogLevel::INFO;
 
     VirtualMemoryManager &vm = VirtualMemoryManager::instance();
@@ -214,6 +219,198 @@ BenchmarkResult bench_working_set_overflow(size_t working_set_size)
     return result;
 }
 
+BenchmarkResult bench_concurrent_hits(size_t working_set_size, size_t num_threads, size_t accesses_per_thread)
+{
+    BenchmarkResult result;
+    result.name = "Concurrent GPU Hits (" + std::to_string(num_threads) + " threads)";
+    result.working_set_size = working_set_size;
+    result.gpu_memory = 2 * working_set_size;
+
+    VMConfig config;
+    config.page_size = 64 * 1024;
+    config.gpu_memory = 2 * working_set_size;
+    config.replacement_policy = PageReplacementPolicy::LRU;
+    config.use_gpu_simulator = true;
+    config.log_level = LogLevel::INFO;
+
+    VirtualMemoryManager &vm = VirtualMemoryManager::instance();
+    vm.initialize(config);
+
+    void *vaddr = vm.allocate(working_set_size);
+    if (!vaddr)
+        return result;
+
+    // Make every page resident so the timed loop only exercises the hit path.
+    size_t num_pages = working_set_size / config.page_size;
+    vm.prefetch_to_gpu(vaddr, working_set_size);
+    vm.reset_counters();
+
+    auto bench_start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; t++)
+    {
+        threads.emplace_back([&vm, vaddr, num_pages, accesses_per_thread, &config, t]()
+                             {
+            std::mt19937_64 rng(t + 1);
+            std::uniform_int_distribution<size_t> dist(0, num_pages - 1);
+            for (size_t i = 0; i < accesses_per_thread; i++)
+            {
+                vm.touch_page((uint8_t *)vaddr + dist(rng) * config.page_size);
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    auto bench_end = std::chrono::high_resolution_clock::now();
+    uint64_t elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                              bench_end - bench_start)
+                              .count();
+    elapsed_us = std::max<uint64_t>(elapsed_us, 1);
+
+    const auto &perf = vm.get_perf_counters();
+    result.page_faults = perf.total_page_faults;
+    result.migrations = perf.cpu_to_gpu_migrations + perf.gpu_to_cpu_migrations;
+    result.migrated_bytes = perf.total_bytes_migrated;
+    result.total_time_us = elapsed_us;
+    result.throughput_pages_per_sec = (num_threads * accesses_per_thread * 1e6) / elapsed_us;
+    result.fault_rate_per_second = (result.page_faults * 1e6) / elapsed_us;
+
+    vm.free(vaddr);
+    vm.shutdown();
+
+    return result;
+}
+
+// Migration job submission under producer contention: N threads hand page-sized
+// jobs to two consumers, either through the copy engines' lock-free rings or
+// through a mutex-guarded queue of std::function jobs like the one the engines
+// replaced. The executor does no copy, so the numbers are queueing cost only.
+BenchmarkResult bench_migration_submit(size_t num_producers, size_t jobs_per_producer, bool use_rings)
+{
+    BenchmarkResult result;
+    result.name = std::string(use_rings ? "Copy Engine Rings" : "Mutex Job Queue") + " (" +
+                  std::to_string(num_producers) + " producers)";
+    result.working_set_size = 0;
+    result.gpu_memory = 0;
+
+    const size_t num_consumers = 2;
+    const size_t total_jobs = num_producers * jobs_per_producer;
+    std::atomic<size_t> completed{0};
+    std::atomic<uint64_t> submit_ns{0};
+
+    std::vector<std::unique_ptr<CopyEngine>> engines;
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::queue<std::pair<VirtualPageNumber, std::function<void()>>> queue;
+    bool queue_done = false;
+    std::vector<std::thread> workers;
+
+    for (size_t i = 0; i < num_consumers; i++)
+    {
+        if (use_rings)
+        {
+            engines.push_back(std::make_unique<CopyEngine>(
+                MigrationDirection::HOST_TO_DEVICE, i, 1024, [](const MigrationDescriptor &)
+                { return (uint64_t)0; },
+                [&completed](const MigrationDescriptor &, uint64_t)
+                { completed++; }));
+            continue;
+        }
+        workers.emplace_back([&]()
+                             {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            while (true)
+            {
+                queue_cv.wait(lock, [&]()
+                              { return queue_done || !queue.empty(); });
+                if (queue.empty())
+                    break;
+                auto job = std::move(queue.front().second);
+                queue.pop();
+                lock.unlock();
+                job();
+                lock.lock();
+            } });
+    }
+
+    auto bench_start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> producers;
+    for (size_t t = 0; t < num_producers; t++)
+    {
+        producers.emplace_back([&, t]()
+                               {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < jobs_per_producer; i++)
+            {
+                MigrationDescriptor desc{};
+                desc.vpn = t * jobs_per_producer + i + 1;
+                desc.bytes = 64 * 1024;
+                desc.direction = MigrationDirection::HOST_TO_DEVICE;
+                desc.priority = MigrationPriority::DEMAND;
+                if (use_rings)
+                {
+                    // Round-robin over the engines; like MigrationManager, a producer that
+                    // finds the ring full runs the job itself instead of waiting.
+                    if (!engines[desc.vpn % num_consumers]->try_submit(desc))
+                    {
+                        completed++;
+                    }
+                }
+                else
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(queue_mutex);
+                        queue.emplace(desc.vpn, [desc, &completed]()
+                                      { completed += desc.bytes ? 1 : 0; });
+                    }
+                    queue_cv.notify_one();
+                }
+            }
+            submit_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::high_resolution_clock::now() - start)
+                             .count(); });
+    }
+    for (auto &producer : producers)
+    {
+        producer.join();
+    }
+    while (completed.load() < total_jobs)
+    {
+        std::this_thread::yield();
+    }
+
+    auto bench_end = std::chrono::high_resolution_clock::now();
+    uint64_t elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                              bench_end - bench_start)
+                              .count();
+    elapsed_us = std::max<uint64_t>(elapsed_us, 1);
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        queue_done = true;
+    }
+    queue_cv.notify_all();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    engines.clear();
+
+    result.page_faults = 0;
+    result.migrations = total_jobs;
+    result.migrated_bytes = 0;
+    result.total_time_us = elapsed_us;
+    result.throughput_pages_per_sec = (total_jobs * 1e6) / elapsed_us;
+    result.fault_rate_per_second = 0;
+    result.avg_submit_ns = (double)submit_ns.load() / total_jobs;
+
+    return result;
+}
+
 void print_benchmark_header()
 {
     std::cout << "\n"
@@ -245,6 +442,10 @@ void print_benchmark_result(const BenchmarkResult &result)
               << result.throughput_pages_per_sec << " pages/sec" << std::endl;
     std::cout << "Fault Rate:              " << std::fixed << std::setprecision(1)
               << result.fault_rate_per_second << " faults/sec" << std::endl;
+    if (result.avg_submit_ns > 0)
+    {
+        std::cout << "Avg Submit Cost:         " << std::setprecision(1) << result.avg_submit_ns << " ns/job" << std::endl;
+    }
 }
 
 void save_results_to_csv(const std::vector<BenchmarkResult> &results, const std::string &filename)
@@ -258,7 +459,7 @@ void save_results_to_csv(const std::vector<BenchmarkResult> &results, const std:
 
     
     csv << "Benchmark,Working_Set_MB,GPU_Memory_MB,Page_Faults,Migrations,"
-        << "Migrated_MB,Total_Time_us,Throughput_pages_sec,Fault_Rate_per_sec\n";
+        << "Migrated_MB,Total_Time_us,Throughput_pages_sec,Fault_Rate_per_sec,Avg_Submit_ns\n";
 
     
     for (const auto &result : results)
@@ -271,7 +472,8 @@ void save_results_to_csv(const std::vector<BenchmarkResult> &results, const std:
             << (result.migrated_bytes / (1024.0 * 1024.0)) << ","
             << result.total_time_us << ","
             << result.throughput_pages_per_sec << ","
-            << result.fault_rate_per_second << "\n";
+            << result.fault_rate_per_second << ","
+            << result.avg_submit_ns << "\n";
     }
 
     csv.close();
@@ -294,6 +496,32 @@ int main(int argc, char **argv)
     std::cout << "\nRunning Working Set Overflow Benchmark (1 GB > 512 MB GPU)..." << std::endl;
     results.push_back(bench_working_set_overflow(1UL * 1024 * 1024 * 1024));
 
+    // Every hit still takes the manager lock shared and its page's stripe, so
+    // this sweep shows how far hit throughput scales with threads.
+    std::cout << "\nRunning Concurrent Hit Benchmark (64 MB resident, 1 to 8 threads)..." << std::endl;
+    double single_thread_rate = 0;
+    for (size_t threads : {1, 2, 4, 8})
+    {
+        results.push_back(bench_concurrent_hits(64UL * 1024 * 1024, threads, 200000));
+        double rate = results.back().throughput_pages_per_sec;
+        if (threads == 1)
+        {
+            single_thread_rate = rate;
+        }
+        else if (single_thread_rate > 0)
+        {
+            std::cout << "  " << threads << " threads: " << std::fixed << std::setprecision(2)
+                      << rate / single_thread_rate << "x single-thread hit rate" << std::endl;
+        }
+    }
+
+    std::cout << "\nRunning Migration Submit Benchmark (mutex queue vs copy engine rings, 1 and 4 producers)..." << std::endl;
+    for (size_t producers : {1, 4})
+    {
+        results.push_back(bench_migration_submit(producers, 100000, false));
+        results.push_back(bench_migration_submit(producers, 100000, true));
+    }
+
     
     for (const auto &result : results)
     {
@@ -0,0 +1,224 @@
+
+
+#include "../vm/TraceSimulator.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <random>
+#include <cstring>
+
+using namespace uvm_sim;
+
+struct SimOptions
+{
+    std::string trace_file;
+    std::vector<size_t> frame_counts = {256, 512, 1024, 2048};
+    size_t page_size = DEFAULT_PAGE_SIZE;
+    size_t trace_page_size = DEFAULT_PAGE_SIZE;
+    size_t synthetic_accesses = 2000000;
+    std::string csv_file = "policy_sim_results.csv";
+};
+
+struct Workload
+{
+    std::string name;
+    std::vector<TraceAccess> trace;
+};
+
+std::vector<TraceAccess> make_loop_trace(size_t num_pages, size_t num_accesses)
+{
+    std::vector<TraceAccess> trace;
+    trace.reserve(num_accesses);
+    for (size_t i = 0; i < num_accesses; i++)
+    {
+        trace.push_back({1 + (i % num_pages), false});
+    }
+    return trace;
+}
+
+std::vector<TraceAccess> make_hot_cold_trace(size_t num_pages, size_t num_accesses, uint32_t seed = 42)
+{
+    std::mt19937_64 rng(seed);
+    size_t hot_pages = std::max<size_t>(num_pages / 10, 1);
+    std::uniform_int_distribution<size_t> hot_dist(0, hot_pages - 1);
+    std::uniform_int_distribution<size_t> cold_dist(hot_pages, num_pages - 1);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+
+    std::vector<TraceAccess> trace;
+    trace.reserve(num_accesses);
+    for (size_t i = 0; i < num_accesses; i++)
+    {
+        size_t page = coin(rng) < 0.8 ? hot_dist(rng) : cold_dist(rng);
+        trace.push_back({1 + page, coin(rng) < 0.3});
+    }
+    return trace;
+}
+
+std::vector<TraceAccess> make_scan_with_hot_set_trace(size_t num_pages, size_t num_accesses, uint32_t seed = 7)
+{
+    std::mt19937_64 rng(seed);
+    size_t hot_pages = std::max<size_t>(num_pages / 16, 1);
+    std::uniform_int_distribution<size_t> hot_dist(0, hot_pages - 1);
+
+    std::vector<TraceAccess> trace;
+    trace.reserve(num_accesses);
+    size_t scan_pos = 0;
+    for (size_t i = 0; i < num_accesses; i++)
+    {
+        if (i % 2 == 0)
+        {
+            trace.push_back({1 + hot_dist(rng), true});
+        }
+        else
+        {
+            trace.push_back({1 + hot_pages + (scan_pos++ % (num_pages - hot_pages)), false});
+        }
+    }
+    return trace;
+}
+
+std::vector<size_t> parse_list(const std::string &arg)
+{
+    std::vector<size_t> values;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        if (!item.empty())
+        {
+            values.push_back(std::stoull(item));
+        }
+    }
+    return values;
+}
+
+void print_usage(const char *prog)
+{
+    std::cout << "Usage: " << prog << " [options]\n"
+              << "  --trace FILE              replay a recorded trace (\"<vpn> [r|w]\" per line)\n"
+              << "  --frames N[,N...]         GPU capacities to sweep, in pages\n"
+              << "  --page-size BYTES         simulated page size\n"
+              << "  --trace-page-size BYTES   page size the trace was recorded at\n"
+              << "  --accesses N              length of synthetic traces\n"
+              << "  --csv FILE                results file\n"
+              << "Without --trace, synthetic loop / hot-cold / scan+hot workloads are replayed.\n";
+}
+
+bool parse_options(int argc, char **argv, SimOptions &opts)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--trace" && has_value)
+            opts.trace_file = argv[++i];
+        else if (arg == "--frames" && has_value)
+            opts.frame_counts = parse_list(argv[++i]);
+        else if (arg == "--page-size" && has_value)
+            opts.page_size = std::stoull(argv[++i]);
+        else if (arg == "--trace-page-size" && has_value)
+            opts.trace_page_size = std::stoull(argv[++i]);
+        else if (arg == "--accesses" && has_value)
+            opts.synthetic_accesses = std::stoull(argv[++i]);
+        else if (arg == "--csv" && has_value)
+            opts.csv_file = argv[++i];
+        else
+        {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    return !opts.frame_counts.empty();
+}
+
+void print_result(const std::string &workload, const TraceSimulator::Result &result, const TraceSimulator::Result &optimal)
+{
+    double vs_opt = optimal.misses ? (double)result.misses / (double)optimal.misses : 1.0;
+    std::cout << std::left << std::setw(12) << workload
+              << std::setw(8) << result.gpu_frames
+              << std::setw(7) << result.policy
+              << std::right << std::setw(12) << result.misses
+              << std::setw(10) << std::fixed << std::setprecision(2) << (result.miss_rate() * 100.0)
+              << std::setw(14) << (result.migrated_bytes / (1024.0 * 1024.0))
+              << std::setw(12) << result.evictions
+              << std::setw(10) << vs_opt
+              << std::setw(10) << (result.accesses_per_sec() / 1e6) << "\n";
+}
+
+int main(int argc, char **argv)
+{
+    SimOptions opts;
+    if (!parse_options(argc, argv, opts))
+    {
+        return 1;
+    }
+
+    Logger::instance().set_level(LogLevel::WARN);
+
+    std::vector<Workload> workloads;
+    if (!opts.trace_file.empty())
+    {
+        Workload w{opts.trace_file, TraceSimulator::load_trace(opts.trace_file)};
+        if (w.trace.empty())
+        {
+            std::cerr << "Trace is empty: " << opts.trace_file << std::endl;
+            return 1;
+        }
+        workloads.push_back(std::move(w));
+    }
+    else
+    {
+        size_t largest = *std::max_element(opts.frame_counts.begin(), opts.frame_counts.end());
+        size_t num_pages = largest + largest / 4;
+        opts.trace_page_size = opts.page_size;
+        workloads.push_back({"loop", make_loop_trace(num_pages, opts.synthetic_accesses)});
+        workloads.push_back({"hot-cold", make_hot_cold_trace(num_pages * 4, opts.synthetic_accesses)});
+        workloads.push_back({"scan+hot", make_scan_with_hot_set_trace(num_pages * 4, opts.synthetic_accesses)});
+    }
+
+    std::cout << std::string(95, '=') << "\n";
+    std::cout << "Replacement Policy Trace Simulator (page size " << opts.page_size << " bytes)\n";
+    std::cout << std::string(95, '=') << "\n";
+    std::cout << std::left << std::setw(12) << "Workload" << std::setw(8) << "Frames" << std::setw(7) << "Policy"
+              << std::right << std::setw(12) << "Misses" << std::setw(10) << "Miss %" << std::setw(14) << "Migrated MB"
+              << std::setw(12) << "Evictions" << std::setw(10) << "vs OPT" << std::setw(10) << "Macc/s" << "\n";
+    std::cout << std::string(95, '-') << "\n";
+
+    std::ofstream csv(opts.csv_file);
+    csv << "Workload,Frames,Page_Size,Policy,Accesses,Misses,Miss_Rate,Migrated_MB,Evictions,Writebacks,Accesses_per_sec\n";
+
+    for (const auto &workload : workloads)
+    {
+        for (size_t frames : opts.frame_counts)
+        {
+            TraceSimulator::Config sim_config;
+            sim_config.gpu_frames = frames;
+            sim_config.page_size = opts.page_size;
+            sim_config.trace_page_size = opts.trace_page_size;
+            TraceSimulator sim(sim_config);
+
+            LRUPolicy lru(frames);
+            CLOCKPolicy clock(frames);
+
+            std::vector<TraceSimulator::Result> results;
+            results.push_back(sim.run(workload.trace, lru, "LRU"));
+            results.push_back(sim.run(workload.trace, clock, "CLOCK"));
+            results.push_back(sim.run_optimal(workload.trace));
+
+            for (const auto &result : results)
+            {
+                print_result(workload.name, result, results.back());
+                csv << workload.name << "," << result.gpu_frames << "," << result.page_size << ","
+                    << result.policy << "," << result.accesses << "," << result.misses << ","
+                    << result.miss_rate() << "," << (result.migrated_bytes / (1024.0 * 1024.0)) << ","
+                    << result.evictions << "," << result.writebacks << "," << result.accesses_per_sec() << "\n";
+            }
+        }
+    }
+
+    std::cout << "\nResults saved to: " << opts.csv_file << std::endl;
+    return 0;
+}
@@ -123,6 +123,7 @@ int main(int argc, char **argv)
     vm_config.gpu_memory = 2UL * 1024 * 1024 * 1024; 
     vm_config.replacement_policy = PageReplacementPolicy::LRU;
     vm_config.use_gpu_simulator = true;
+    vm_config.dirty_granule_size = 4096; // sparse per-particle writes only dirty 4 KB granules
     vm_config.log_level = LogLevel::INFO;
 
     VirtualMemoryManager &vm = VirtualMemoryManager::instance();
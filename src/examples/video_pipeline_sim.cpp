@@ -117,6 +117,7 @@ int main(int argc, char **argv)
     vm_config.gpu_memory = 512UL * 1024 * 1024; 
     vm_config.replacement_policy = PageReplacementPolicy::LRU;
     vm_config.use_gpu_simulator = true;
+    vm_config.link_compression = LinkCompression::PATTERN; // gray frames after color conversion are low-entropy
     vm_config.log_level = LogLevel::INFO;
 
     VirtualMemoryManager &vm = VirtualMemoryManager::instance();
@@ -150,20 +151,29 @@ int main(int argc, char **argv)
     auto pipeline_start = std::chrono::high_resolution_clock::now();
     uint64_t frames_processed = 0;
 
+    Stream prefetch_stream;
+    auto prefetch_batch = [&](uint32_t batch_start)
+    {
+        uint32_t batch_end = std::min(batch_start + config.batch_size, config.num_frames);
+        return vm.prefetch_range(frame_buffer + (batch_start * frame_data_size),
+                                 (batch_end - batch_start) * frame_data_size, Location::GPU, &prefetch_stream);
+    };
+
     for (uint32_t pass = 0; pass < config.processing_passes; pass++)
     {
         std::cout << "Processing Pass " << (pass + 1) << " of " << config.processing_passes << "\n";
 
         
+        Event batch_ready = prefetch_batch(0);
         for (uint32_t batch_start = 0; batch_start < config.num_frames; batch_start += config.batch_size)
         {
             uint32_t batch_end = std::min(batch_start + config.batch_size, config.num_frames);
 
-            
-            for (uint32_t i = batch_start; i < batch_end; i++)
+            // Batch N+1 migrates while batch N is processed.
+            batch_ready.synchronize();
+            if (batch_end < config.num_frames)
             {
-                uint8_t *frame_data = frame_buffer + (i * frame_data_size);
-                vm.prefetch_to_gpu(frame_data);
+                batch_ready = prefetch_batch(batch_end);
             }
 
             
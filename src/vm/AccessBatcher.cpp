@@ -0,0 +1,187 @@
+#include "AccessBatcher.h"
+
+namespace uvm_sim
+{
+
+    namespace
+    {
+        std::atomic<uint64_t> next_batcher_id{1};
+
+        // Slots index each thread's LocalBuffers; freed slots are handed out again
+        // so a thread's table stays as small as the number of live batchers.
+        std::mutex slot_mutex;
+        std::vector<size_t> free_slots;
+        size_t next_slot = 0;
+
+        size_t acquire_slot()
+        {
+            std::lock_guard<std::mutex> lock(slot_mutex);
+            if (free_slots.empty())
+            {
+                return next_slot++;
+            }
+            size_t slot = free_slots.back();
+            free_slots.pop_back();
+            return slot;
+        }
+
+        void release_slot(size_t slot)
+        {
+            std::lock_guard<std::mutex> lock(slot_mutex);
+            free_slots.push_back(slot);
+        }
+    }
+
+    thread_local AccessBatcher::LocalBuffers AccessBatcher::local_;
+
+    AccessBatcher::AccessBatcher(ReplacementPolicy *policy, size_t batch_size)
+        : policy_(policy), batch_size_(std::max<size_t>(batch_size, 1)), id_(next_batcher_id++),
+          slot_(acquire_slot()), registry_(std::make_shared<Registry>())
+    {
+        capacity_ = 1;
+        while (capacity_ < batch_size_ * 2)
+        {
+            capacity_ <<= 1;
+        }
+        scratch_.reserve(capacity_);
+        registry_->owner = this;
+    }
+
+    AccessBatcher::~AccessBatcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(registry_->mutex);
+            for (auto &buffer : registry_->buffers)
+            {
+                drain(buffer.get());
+            }
+            registry_->owner = nullptr;
+            registry_->buffers.clear();
+        }
+
+        // Other threads' entries for this slot are recognized as stale by id.
+        if (slot_ < local_.entries.size() && local_.entries[slot_].id == id_)
+        {
+            local_.entries[slot_] = LocalBuffers::Entry();
+        }
+        release_slot(slot_);
+    }
+
+    void AccessBatcher::Registry::release(ThreadBuffer *buffer)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!owner)
+        {
+            return;
+        }
+
+        owner->drain(buffer);
+        auto it = std::find_if(buffers.begin(), buffers.end(), [buffer](const std::unique_ptr<ThreadBuffer> &b)
+                               { return b.get() == buffer; });
+        if (it != buffers.end())
+        {
+            buffers.erase(it);
+        }
+    }
+
+    AccessBatcher::LocalBuffers::~LocalBuffers()
+    {
+        // Thread exit: flush what this thread logged and give its buffers back.
+        for (auto &entry : entries)
+        {
+            if (auto registry = entry.registry.lock())
+            {
+                registry->release(entry.buffer);
+            }
+        }
+    }
+
+    AccessBatcher::ThreadBuffer *AccessBatcher::local_buffer()
+    {
+        auto &entries = local_.entries;
+        if (slot_ < entries.size() && entries[slot_].id == id_)
+        {
+            return entries[slot_].buffer;
+        }
+        return register_thread();
+    }
+
+    AccessBatcher::ThreadBuffer *AccessBatcher::register_thread()
+    {
+        ThreadBuffer *buffer;
+        {
+            std::lock_guard<std::mutex> lock(registry_->mutex);
+            registry_->buffers.push_back(std::make_unique<ThreadBuffer>(capacity_));
+            buffer = registry_->buffers.back().get();
+        }
+
+        auto &entries = local_.entries;
+        if (slot_ >= entries.size())
+        {
+            entries.resize(slot_ + 1);
+        }
+        entries[slot_].id = id_;
+        entries[slot_].buffer = buffer;
+        entries[slot_].registry = registry_;
+        return buffer;
+    }
+
+    void AccessBatcher::record(VirtualPageNumber vpn)
+    {
+        ThreadBuffer *buffer = local_buffer();
+
+        size_t head = buffer->head.load(std::memory_order_relaxed);
+        if (head - buffer->tail.load(std::memory_order_acquire) >= capacity_)
+        {
+            drain(buffer);
+        }
+
+        buffer->slots[head & (capacity_ - 1)] = vpn;
+        buffer->head.store(head + 1, std::memory_order_release);
+        recorded_.fetch_add(1, std::memory_order_relaxed);
+
+        if (head + 1 - buffer->tail.load(std::memory_order_acquire) >= batch_size_)
+        {
+            drain(buffer);
+        }
+    }
+
+    void AccessBatcher::drain(ThreadBuffer *buffer)
+    {
+        std::lock_guard<std::mutex> lock(drain_mutex_);
+
+        size_t tail = buffer->tail.load(std::memory_order_relaxed);
+        size_t head = buffer->head.load(std::memory_order_acquire);
+        if (head == tail)
+        {
+            return;
+        }
+
+        scratch_.clear();
+        for (size_t i = tail; i != head; i++)
+        {
+            scratch_.push_back(buffer->slots[i & (capacity_ - 1)]);
+        }
+        buffer->tail.store(head, std::memory_order_release);
+
+        policy_->on_page_access_batch(scratch_.data(), scratch_.size());
+        batches_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void AccessBatcher::drain_all()
+    {
+        // Held throughout so an exiting thread cannot free its buffer mid-drain.
+        std::lock_guard<std::mutex> lock(registry_->mutex);
+        for (auto &buffer : registry_->buffers)
+        {
+            drain(buffer.get());
+        }
+    }
+
+    size_t AccessBatcher::get_thread_buffers() const
+    {
+        std::lock_guard<std::mutex> lock(registry_->mutex);
+        return registry_->buffers.size();
+    }
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Common.h"
+#include "Policies.h"
+
+namespace uvm_sim
+{
+
+    // Per-thread access logs in front of a ReplacementPolicy, in the spirit of
+    // Linux's LRU pagevecs. record() appends to the calling thread's ring
+    // without touching the policy lock; a ring is handed to the policy in one
+    // on_page_access_batch() call every batch_size accesses, and drain_all()
+    // flushes every ring before a victim is chosen.
+    class AccessBatcher
+    {
+    public:
+        explicit AccessBatcher(ReplacementPolicy *policy, size_t batch_size = 16);
+        ~AccessBatcher();
+
+        
+        void record(VirtualPageNumber vpn);
+
+        
+        void drain_all();
+
+        size_t get_batch_size() const { return batch_size_; }
+        uint64_t get_recorded() const { return recorded_.load(std::memory_order_relaxed); }
+        uint64_t get_batches() const { return batches_.load(std::memory_order_relaxed); }
+        size_t get_thread_buffers() const;
+
+    private:
+        // Single-producer ring owned by one thread; consumers are serialized by drain_mutex_.
+        struct ThreadBuffer
+        {
+            explicit ThreadBuffer(size_t capacity) : slots(capacity) {}
+
+            std::vector<VirtualPageNumber> slots;
+            alignas(64) std::atomic<size_t> head{0};
+            alignas(64) std::atomic<size_t> tail{0};
+        };
+
+        // Buffers of live threads. Shared with each thread's exit hook so a
+        // thread that outlives the batcher, or dies first, cleans up safely.
+        struct Registry
+        {
+            std::mutex mutex;
+            AccessBatcher *owner = nullptr;
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+            void release(ThreadBuffer *buffer);
+        };
+
+        // The calling thread's buffers, indexed by batcher slot. Slots are reused
+        // once a batcher is gone, so entries carry the batcher id as well.
+        struct LocalBuffers
+        {
+            struct Entry
+            {
+                uint64_t id = 0;
+                ThreadBuffer *buffer = nullptr;
+                std::weak_ptr<Registry> registry;
+            };
+
+            std::vector<Entry> entries;
+
+            ~LocalBuffers();
+        };
+
+        ThreadBuffer *local_buffer();
+        ThreadBuffer *register_thread();
+        void drain(ThreadBuffer *buffer);
+
+        ReplacementPolicy *policy_;
+        size_t batch_size_;
+        size_t capacity_;
+        uint64_t id_;
+        size_t slot_;
+
+        std::shared_ptr<Registry> registry_;
+        std::mutex drain_mutex_;
+        std::vector<VirtualPageNumber> scratch_;
+
+        static thread_local LocalBuffers local_;
+
+        std::atomic<uint64_t> recorded_{0};
+        std::atomic<uint64_t> batches_{0};
+    };
+
+}
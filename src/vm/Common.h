@@ -41,6 +41,23 @@ namespace uvm_sim
         UNALLOCATED = 3
     };
 
+    enum class Location : uint8_t
+    {
+        CPU = 0,
+        GPU = 1
+    };
+
+    // Usage hints for VirtualMemoryManager::advise, after cudaMemAdvise.
+    enum class Advice : uint8_t
+    {
+        SET_READ_MOSTLY = 0,
+        UNSET_READ_MOSTLY = 1,
+        SET_PREFERRED_LOCATION = 2,
+        UNSET_PREFERRED_LOCATION = 3,
+        SET_ACCESSED_BY = 4,
+        UNSET_ACCESSED_BY = 5
+    };
+
     enum class PageReplacementPolicy : uint8_t
     {
         LRU = 0,
@@ -66,8 +83,24 @@ namespace uvm_sim
         std::atomic<uint64_t> tlb_hits{0};
         std::atomic<uint64_t> tlb_misses{0};
         std::atomic<uint64_t> evictions{0};
+        std::atomic<uint64_t> background_evictions{0};
+        std::atomic<uint64_t> direct_evictions{0};
+        std::atomic<uint64_t> clean_evictions{0};
         std::atomic<uint64_t> kernel_launches{0};
         std::atomic<uint64_t> page_prefetches{0};
+        std::atomic<uint64_t> admission_rejections{0};
+        std::atomic<uint64_t> remote_accesses{0};
+        std::atomic<uint64_t> thrashing_events{0};
+        std::atomic<uint64_t> thrash_pins{0};
+        std::atomic<uint64_t> thrash_throttles{0};
+        std::atomic<uint64_t> thrash_remote_maps{0};
+        std::atomic<uint64_t> migration_batches{0};
+        std::atomic<uint64_t> migration_batch_copies{0};
+        std::atomic<uint64_t> delta_migrations{0};
+        std::atomic<uint64_t> delta_bytes_saved{0};
+        std::atomic<uint64_t> zero_page_fills{0};
+        std::atomic<uint64_t> zero_page_elisions{0};
+        std::atomic<uint64_t> in_flight_waits{0}; // accesses that waited on another thread's copy of their page
 
         void reset()
         {
@@ -79,8 +112,24 @@ namespace uvm_sim
             tlb_hits = 0;
             tlb_misses = 0;
             evictions = 0;
+            background_evictions = 0;
+            direct_evictions = 0;
+            clean_evictions = 0;
             kernel_launches = 0;
             page_prefetches = 0;
+            admission_rejections = 0;
+            remote_accesses = 0;
+            thrashing_events = 0;
+            thrash_pins = 0;
+            thrash_throttles = 0;
+            thrash_remote_maps = 0;
+            migration_batches = 0;
+            migration_batch_copies = 0;
+            delta_migrations = 0;
+            delta_bytes_saved = 0;
+            zero_page_fills = 0;
+            zero_page_elisions = 0;
+            in_flight_waits = 0;
         }
 
         void print() const
@@ -107,8 +156,24 @@ namespace uvm_sim
                           << hit_rate << std::endl;
             }
             std::cout << "Page Evictions:              " << evictions << std::endl;
+            std::cout << "  By Background Reclaim:     " << background_evictions << std::endl;
+            std::cout << "  In Fault Path:             " << direct_evictions << std::endl;
+            std::cout << "  Clean (No Writeback):      " << clean_evictions << std::endl;
             std::cout << "Kernel Launches:             " << kernel_launches << std::endl;
             std::cout << "Page Prefetches:             " << page_prefetches << std::endl;
+            std::cout << "Admission Rejections:        " << admission_rejections << std::endl;
+            std::cout << "Remote (Zero-Copy) Accesses: " << remote_accesses << std::endl;
+            std::cout << "Thrashing Events:            " << thrashing_events << std::endl;
+            std::cout << "  Mitigated by Pinning:      " << thrash_pins << std::endl;
+            std::cout << "  Mitigated by Throttling:   " << thrash_throttles << std::endl;
+            std::cout << "  Mitigated by Remote Map:   " << thrash_remote_maps << std::endl;
+            std::cout << "Batched Migrations:          " << migration_batches
+                      << " (" << migration_batch_copies << " coalesced copies)" << std::endl;
+            std::cout << "Delta Migrations:            " << delta_migrations
+                      << " (" << delta_bytes_saved << " bytes not copied)" << std::endl;
+            std::cout << "Zero-Page Fills:             " << zero_page_fills
+                      << " (" << zero_page_elisions << " writebacks elided)" << std::endl;
+            std::cout << "Waits on In-Flight Copies:   " << in_flight_waits << std::endl;
         }
     };
 
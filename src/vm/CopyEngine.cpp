@@ -0,0 +1,146 @@
+#include "CopyEngine.h"
+
+namespace uvm_sim
+{
+
+    namespace
+    {
+        inline uint64_t steady_now_ns()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+    }
+
+    CopyEngine::CopyEngine(MigrationDirection direction, size_t id, size_t queue_capacity, Executor executor,
+                           Completion on_complete, std::function<bool()> writeback_urgent)
+        : direction_(direction), id_(id), executor_(std::move(executor)), on_complete_(std::move(on_complete)),
+          writeback_urgent_(std::move(writeback_urgent)), created_(std::chrono::steady_clock::now())
+    {
+        for (auto &queue : queues_)
+        {
+            queue = std::make_unique<MPMCQueue<MigrationDescriptor>>(queue_capacity);
+        }
+        worker_ = std::thread(&CopyEngine::worker_thread, this);
+    }
+
+    CopyEngine::~CopyEngine()
+    {
+        shutdown_.store(true, std::memory_order_release);
+        work_available_.notify_all();
+        if (worker_.joinable())
+        {
+            worker_.join();
+        }
+    }
+
+    bool CopyEngine::try_submit(MigrationDescriptor desc)
+    {
+        desc.enqueued_ns = steady_now_ns();
+
+        // Count first so the worker never sees a job it cannot account for.
+        size_t queued = queued_.fetch_add(1, std::memory_order_seq_cst);
+        size_t depth = queued + 1 + (is_busy() ? 1 : 0);
+        if (!queues_[(int)desc.priority]->try_push(desc))
+        {
+            queued_.fetch_sub(1, std::memory_order_acq_rel);
+            return false;
+        }
+
+        size_t max_depth = max_queue_depth_.load(std::memory_order_relaxed);
+        while (depth > max_depth && !max_queue_depth_.compare_exchange_weak(max_depth, depth, std::memory_order_relaxed))
+        {
+        }
+
+        // The worker does not sleep while queued_ is nonzero, so only the job that
+        // found the engine empty has to wake it; the rest skip the futex.
+        if (queued == 0)
+        {
+            work_available_.notify_one();
+        }
+        return true;
+    }
+
+    uint64_t CopyEngine::get_jobs_completed(MigrationPriority priority) const
+    {
+        return completed_by_priority_[(int)priority].load(std::memory_order_relaxed);
+    }
+
+    double CopyEngine::get_avg_wait_us(MigrationPriority priority) const
+    {
+        uint64_t completed = get_jobs_completed(priority);
+        uint64_t wait_ns = wait_ns_by_priority_[(int)priority].load(std::memory_order_relaxed);
+        return completed ? (double)wait_ns / (double)completed / 1000.0 : 0.0;
+    }
+
+    double CopyEngine::get_utilization() const
+    {
+        auto lifetime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - created_)
+                               .count();
+        return lifetime_ns > 0 ? (double)busy_ns_.load(std::memory_order_relaxed) / (double)lifetime_ns : 0.0;
+    }
+
+    bool CopyEngine::pop_next(MigrationDescriptor &desc)
+    {
+        bool urgent = writeback_urgent_ && !queues_[(int)MigrationPriority::WRITEBACK]->empty() && writeback_urgent_();
+        const MigrationPriority order[NUM_MIGRATION_PRIORITIES] = {
+            MigrationPriority::DEMAND,
+            urgent ? MigrationPriority::WRITEBACK : MigrationPriority::PREFETCH,
+            urgent ? MigrationPriority::PREFETCH : MigrationPriority::WRITEBACK};
+
+        for (auto priority : order)
+        {
+            if (queues_[(int)priority]->try_pop(desc))
+            {
+                // Mark busy before the queued count drops so the engine never looks idle mid-handoff.
+                busy_.store(true, std::memory_order_release);
+                queued_.fetch_sub(1, std::memory_order_acq_rel);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void CopyEngine::worker_thread()
+    {
+        while (true)
+        {
+            MigrationDescriptor desc;
+            if (!pop_next(desc))
+            {
+                uint32_t key = work_available_.prepare_wait();
+                if (queued_.load(std::memory_order_seq_cst) > 0)
+                {
+                    // A producer has counted a job it is still publishing.
+                    work_available_.cancel_wait();
+                    std::this_thread::yield();
+                    continue;
+                }
+                // Drain queued transfers before exiting so every waiter is released.
+                if (shutdown_.load(std::memory_order_acquire))
+                {
+                    work_available_.cancel_wait();
+                    break;
+                }
+                work_available_.wait(key);
+                continue;
+            }
+
+            uint64_t start_ns = steady_now_ns();
+            wait_ns_by_priority_[(int)desc.priority].fetch_add(start_ns - desc.enqueued_ns, std::memory_order_relaxed);
+
+            uint64_t time_us = executor_(desc);
+
+            busy_ns_.fetch_add(steady_now_ns() - start_ns, std::memory_order_relaxed);
+            bytes_copied_.fetch_add(desc.bytes, std::memory_order_relaxed);
+            jobs_completed_.fetch_add(1, std::memory_order_relaxed);
+            completed_by_priority_[(int)desc.priority].fetch_add(1, std::memory_order_relaxed);
+            busy_.store(false, std::memory_order_release);
+
+            on_complete_(desc, time_us);
+        }
+    }
+
+}
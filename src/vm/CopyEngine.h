@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Common.h"
+#include "LinkModel.h"
+#include "MPMCQueue.h"
+#include "EventCount.h"
+#include <functional>
+
+namespace uvm_sim
+{
+
+    enum class MigrationPriority : uint8_t
+    {
+        DEMAND = 0,    // a thread is blocked on this page
+        WRITEBACK = 1, // eviction writeback freeing a GPU frame
+        PREFETCH = 2   // speculative
+    };
+
+    constexpr size_t NUM_MIGRATION_PRIORITIES = 3;
+
+    // Plain description of one page transfer; the completion slot indexes the
+    // owner's table of waiters so nothing is heap-allocated per job.
+    struct MigrationDescriptor
+    {
+        VirtualPageNumber vpn;
+        void *cpu_addr;
+        uint64_t gpu_addr;
+        uint64_t bytes;
+        uint64_t ticket;
+        uint64_t enqueued_ns;
+        uint32_t completion_slot;
+        MigrationDirection direction;
+        MigrationPriority priority;
+        uint64_t granules = 0;     // when set, only these granule_size chunks of the page move
+        uint32_t granule_size = 0;
+    };
+
+    
+    
+    
+
+    // One DMA channel: transfers in a single direction served by a dedicated
+    // thread. MigrationManager owns a set of these per direction so
+    // device-to-host writebacks overlap host-to-device fills like they do on
+    // hardware copy engines. Demand transfers always run first; writebacks run
+    // ahead of prefetches only while writeback_urgent() reports the free-frame
+    // reserve is short, and behind them otherwise. Order within a priority is FIFO.
+    //
+    // Each priority is a bounded lock-free ring, so submitting never takes a
+    // lock; an idle worker sleeps on an EventCount.
+    class CopyEngine
+    {
+    public:
+        // The executor performs the copy and returns its modeled time; completion
+        // runs after the engine's own counters are updated.
+        using Executor = std::function<uint64_t(const MigrationDescriptor &)>;
+        using Completion = std::function<void(const MigrationDescriptor &, uint64_t)>;
+
+        CopyEngine(MigrationDirection direction, size_t id, size_t queue_capacity, Executor executor,
+                   Completion on_complete, std::function<bool()> writeback_urgent = nullptr);
+        ~CopyEngine();
+
+        CopyEngine(const CopyEngine &) = delete;
+        CopyEngine &operator=(const CopyEngine &) = delete;
+
+        // Returns false when the ring for this priority is full.
+        bool try_submit(MigrationDescriptor desc);
+
+        
+        size_t get_queue_depth() const { return get_queued() + (is_busy() ? 1 : 0); }
+        size_t get_queued() const { return queued_.load(std::memory_order_acquire); }
+        bool is_busy() const { return busy_.load(std::memory_order_acquire); }
+
+        MigrationDirection get_direction() const { return direction_; }
+        size_t get_id() const { return id_; }
+        uint64_t get_jobs_completed() const { return jobs_completed_.load(std::memory_order_relaxed); }
+        uint64_t get_bytes_copied() const { return bytes_copied_.load(std::memory_order_relaxed); }
+        uint64_t get_busy_us() const { return busy_ns_.load(std::memory_order_relaxed) / 1000; }
+        size_t get_max_queue_depth() const { return max_queue_depth_.load(std::memory_order_relaxed); }
+        uint64_t get_jobs_completed(MigrationPriority priority) const;
+
+        // Mean time transfers of this priority spent queued before starting.
+        double get_avg_wait_us(MigrationPriority priority) const;
+
+        // Fraction of the engine's lifetime spent executing transfers.
+        double get_utilization() const;
+
+    private:
+        void worker_thread();
+
+        
+        bool pop_next(MigrationDescriptor &desc);
+
+        MigrationDirection direction_;
+        size_t id_;
+        Executor executor_;
+        Completion on_complete_;
+        std::function<bool()> writeback_urgent_;
+        std::chrono::steady_clock::time_point created_;
+
+        std::unique_ptr<MPMCQueue<MigrationDescriptor>> queues_[NUM_MIGRATION_PRIORITIES];
+        EventCount work_available_;
+        std::atomic<size_t> queued_{0};
+        std::atomic<bool> busy_{false};
+        std::atomic<bool> shutdown_{false};
+        std::thread worker_;
+
+        std::atomic<uint64_t> jobs_completed_{0};
+        std::atomic<uint64_t> bytes_copied_{0};
+        std::atomic<uint64_t> busy_ns_{0};
+        std::atomic<size_t> max_queue_depth_{0};
+        std::atomic<uint64_t> completed_by_priority_[NUM_MIGRATION_PRIORITIES] = {};
+        std::atomic<uint64_t> wait_ns_by_priority_[NUM_MIGRATION_PRIORITIES] = {};
+    };
+
+}
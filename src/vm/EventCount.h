@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Common.h"
+#include <climits>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace uvm_sim
+{
+
+    // Lets consumers of a lock-free queue sleep without a mutex on the
+    // producer's path. A consumer calls prepare_wait(), re-checks the queue,
+    // then either cancel_wait()s or wait()s on the returned key; a producer
+    // calls notify_*() after publishing, which costs one atomic load when
+    // nobody is sleeping. On Linux sleepers block on a futex.
+    class EventCount
+    {
+    public:
+        uint32_t prepare_wait()
+        {
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            return epoch_.load(std::memory_order_seq_cst);
+        }
+
+        void cancel_wait()
+        {
+            waiters_.fetch_sub(1, std::memory_order_seq_cst);
+        }
+
+        void wait(uint32_t key)
+        {
+            while (epoch_.load(std::memory_order_seq_cst) == key)
+            {
+#ifdef __linux__
+                syscall(SYS_futex, reinterpret_cast<uint32_t *>(&epoch_), FUTEX_WAIT_PRIVATE, key, nullptr, nullptr, 0);
+#else
+                std::this_thread::yield();
+#endif
+            }
+            waiters_.fetch_sub(1, std::memory_order_seq_cst);
+        }
+
+        void notify_one() { notify(1); }
+        void notify_all() { notify(INT_MAX); }
+
+    private:
+        void notify(int count)
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiters_.load(std::memory_order_seq_cst) == 0)
+            {
+                return;
+            }
+            epoch_.fetch_add(1, std::memory_order_seq_cst);
+#ifdef __linux__
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&epoch_), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+#else
+            (void)count;
+#endif
+        }
+
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain uint32_t");
+
+        alignas(64) std::atomic<uint32_t> epoch_{0};
+        std::atomic<uint32_t> waiters_{0};
+    };
+
+}
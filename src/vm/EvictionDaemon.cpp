@@ -0,0 +1,86 @@
+#include "EvictionDaemon.h"
+#include <cmath>
+
+namespace uvm_sim
+{
+
+    EvictionDaemon::EvictionDaemon(const Config &config, size_t total_frames, FreeFrames free_frames, Reclaim reclaim)
+        : config_(config), free_frames_(std::move(free_frames)), reclaim_(std::move(reclaim)),
+          kicked_(false), shutdown_(false)
+    {
+        low_pages_ = std::max<size_t>((size_t)std::ceil(config_.low_watermark * total_frames), 1);
+        high_pages_ = std::max<size_t>((size_t)std::ceil(config_.high_watermark * total_frames), low_pages_ + 1);
+        high_pages_ = std::min(high_pages_, total_frames);
+        low_pages_ = std::min(low_pages_, high_pages_);
+
+        LOG_DEBUG("Eviction daemon: watermarks %zu/%zu free frames of %zu, batch %zu",
+                  low_pages_, high_pages_, total_frames, config_.batch_pages);
+        worker_ = std::thread(&EvictionDaemon::daemon_thread, this);
+    }
+
+    EvictionDaemon::~EvictionDaemon()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            shutdown_ = true;
+        }
+        cv_.notify_all();
+        if (worker_.joinable())
+        {
+            worker_.join();
+        }
+    }
+
+    void EvictionDaemon::wake()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            kicked_ = true;
+        }
+        cv_.notify_one();
+    }
+
+    void EvictionDaemon::daemon_thread()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!shutdown_)
+        {
+            cv_.wait_for(lock, std::chrono::microseconds(config_.interval_us), [this]()
+                         { return kicked_ || shutdown_; });
+            if (shutdown_)
+            {
+                break;
+            }
+            bool kicked = kicked_;
+            kicked_ = false;
+
+            // The periodic check waits for the low watermark; an explicit wake
+            // tops up to the high one even after a partial reclaim.
+            if (kicked ? free_frames_() >= high_pages_ : !below_low_watermark())
+            {
+                continue;
+            }
+
+            wakeups_++;
+            lock.unlock();
+            balance();
+            lock.lock();
+        }
+    }
+
+    void EvictionDaemon::balance()
+    {
+        size_t free_frames = free_frames_();
+        while (free_frames < high_pages_)
+        {
+            size_t reclaimed = reclaim_(std::min(config_.batch_pages, high_pages_ - free_frames));
+            if (reclaimed == 0)
+            {
+                break;
+            }
+            pages_reclaimed_ += reclaimed;
+            free_frames = free_frames_();
+        }
+    }
+
+}
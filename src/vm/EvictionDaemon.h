@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Common.h"
+#include <condition_variable>
+#include <functional>
+#include <thread>
+
+namespace uvm_sim
+{
+
+    // Background reclaimer in the spirit of kswapd. When free GPU frames drop
+    // below the low watermark it evicts in batches until the high watermark is
+    // restored, so faults normally find a free frame without evicting inline.
+    // The owner supplies how to count free frames and how to reclaim a batch.
+    class EvictionDaemon
+    {
+    public:
+        struct Config
+        {
+            double low_watermark = 0.05;  // fraction of GPU frames; wake below this
+            double high_watermark = 0.10; // reclaim until this fraction is free
+            size_t batch_pages = 32;      // pages evicted per reclaim call
+            uint64_t interval_us = 1000;  // periodic check even without a wakeup
+        };
+
+        using FreeFrames = std::function<size_t()>;
+        using Reclaim = std::function<size_t(size_t max_pages)>;
+
+        EvictionDaemon(const Config &config, size_t total_frames, FreeFrames free_frames, Reclaim reclaim);
+        ~EvictionDaemon();
+
+        EvictionDaemon(const EvictionDaemon &) = delete;
+        EvictionDaemon &operator=(const EvictionDaemon &) = delete;
+
+        // Reclaims up to the high watermark now, whether or not free frames are
+        // below the low one.
+        void wake();
+
+        
+        bool below_low_watermark() const { return free_frames_() < low_pages_; }
+
+        size_t get_low_watermark_pages() const { return low_pages_; }
+        size_t get_high_watermark_pages() const { return high_pages_; }
+        uint64_t get_wakeups() const { return wakeups_.load(std::memory_order_relaxed); }
+        uint64_t get_pages_reclaimed() const { return pages_reclaimed_.load(std::memory_order_relaxed); }
+
+    private:
+        void daemon_thread();
+
+        
+        void balance();
+
+        Config config_;
+        size_t low_pages_;
+        size_t high_pages_;
+        FreeFrames free_frames_;
+        Reclaim reclaim_;
+
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        bool kicked_;
+        bool shutdown_;
+        std::thread worker_;
+
+        std::atomic<uint64_t> wakeups_{0};
+        std::atomic<uint64_t> pages_reclaimed_{0};
+    };
+
+}
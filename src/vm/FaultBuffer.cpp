@@ -0,0 +1,97 @@
+#include "FaultBuffer.h"
+
+namespace uvm_sim
+{
+
+    FaultBuffer::FaultBuffer(const Config &config, Service service)
+        : config_(config), service_(std::move(service)), appended_(0), serviced_(0), shutdown_(false)
+    {
+        config_.batch_size = std::max<size_t>(config_.batch_size, 1);
+        worker_ = std::thread(&FaultBuffer::service_thread, this);
+    }
+
+    FaultBuffer::~FaultBuffer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            shutdown_ = true;
+        }
+        fault_cv_.notify_all();
+        if (worker_.joinable())
+        {
+            worker_.join();
+        }
+    }
+
+    uint64_t FaultBuffer::fault_and_wait(VirtualPageNumber vpn)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        uint64_t ticket = ++appended_;
+        pending_.push_back(vpn);
+        faults_++;
+        fault_cv_.notify_one();
+        replay_cv_.wait(lock, [this, ticket]()
+                        { return serviced_ >= ticket; });
+
+        auto it = throttles_.find(ticket);
+        if (it == throttles_.end())
+        {
+            return 0;
+        }
+        uint64_t throttle_us = it->second;
+        throttles_.erase(it);
+        return throttle_us;
+    }
+
+    void FaultBuffer::service_thread()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            fault_cv_.wait(lock, [this]()
+                           { return shutdown_ || !pending_.empty(); });
+            // Service what is left before exiting so no accessor stays parked.
+            if (pending_.empty())
+            {
+                break;
+            }
+
+            if (config_.batch_window_us && !shutdown_)
+            {
+                fault_cv_.wait_for(lock, std::chrono::microseconds(config_.batch_window_us), [this]()
+                                   { return shutdown_ || pending_.size() >= config_.batch_size; });
+            }
+
+            size_t taken = std::min(pending_.size(), config_.batch_size);
+            std::vector<VirtualPageNumber> faults(pending_.begin(), pending_.begin() + taken);
+            pending_.erase(pending_.begin(), pending_.begin() + taken);
+            lock.unlock();
+
+            std::vector<VirtualPageNumber> batch(faults);
+            std::sort(batch.begin(), batch.end());
+            batch.erase(std::unique(batch.begin(), batch.end()), batch.end());
+            duplicates_ += taken - batch.size();
+            batches_++;
+            if (taken > max_batch_)
+            {
+                max_batch_ = taken;
+            }
+            std::vector<uint64_t> throttle_us(batch.size(), 0);
+            service_(batch, throttle_us);
+
+            lock.lock();
+            // Faults are taken in append order, so the i-th one holds ticket serviced_ + i + 1.
+            for (size_t i = 0; i < taken; i++)
+            {
+                size_t index = std::lower_bound(batch.begin(), batch.end(), faults[i]) - batch.begin();
+                if (throttle_us[index])
+                {
+                    throttles_[serviced_ + i + 1] = throttle_us[index];
+                }
+            }
+            serviced_ += taken;
+            replay_cv_.notify_all();
+        }
+    }
+
+}
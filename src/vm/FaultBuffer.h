@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Common.h"
+#include <condition_variable>
+#include <functional>
+#include <thread>
+
+namespace uvm_sim
+{
+
+    // Replayable GPU fault buffer. An access that misses appends its VPN and
+    // stalls; a servicing thread drains the buffer in batches, sorts and
+    // deduplicates each one, hands it to the owner to service, then replays
+    // every access waiting on that batch. Faults raised while a batch is in
+    // service gather in the buffer and are serviced together next.
+    class FaultBuffer
+    {
+    public:
+        struct Config
+        {
+            size_t batch_size = 256;      // faults drained per batch
+            uint64_t batch_window_us = 0; // wait up to this long for a batch to fill; 0 services what is there
+        };
+
+        // Receives each batch sorted by VPN without duplicates, and may set how
+        // long each faulting access should be throttled once it is replayed.
+        using Service = std::function<void(const std::vector<VirtualPageNumber> &vpns, std::vector<uint64_t> &throttle_us)>;
+
+        FaultBuffer(const Config &config, Service service);
+        ~FaultBuffer();
+
+        FaultBuffer(const FaultBuffer &) = delete;
+        FaultBuffer &operator=(const FaultBuffer &) = delete;
+
+        
+        // Blocks until the batch holding this fault has been serviced; returns the
+        // throttle the service asked for this access, in microseconds.
+        uint64_t fault_and_wait(VirtualPageNumber vpn);
+
+        uint64_t get_faults() const { return faults_.load(std::memory_order_relaxed); }
+        uint64_t get_batches() const { return batches_.load(std::memory_order_relaxed); }
+        uint64_t get_duplicates() const { return duplicates_.load(std::memory_order_relaxed); }
+        uint64_t get_max_batch() const { return max_batch_.load(std::memory_order_relaxed); }
+
+    private:
+        void service_thread();
+
+        Config config_;
+        Service service_;
+
+        std::mutex mutex_;
+        std::condition_variable fault_cv_;
+        std::condition_variable replay_cv_;
+        std::vector<VirtualPageNumber> pending_;
+        uint64_t appended_; // faults ever appended; a fault's ticket is its position
+        uint64_t serviced_; // faults ever serviced, in append order
+        std::unordered_map<uint64_t, uint64_t> throttles_; // ticket -> throttle_us, until its waiter collects it
+        bool shutdown_;
+        std::thread worker_;
+
+        std::atomic<uint64_t> faults_{0};
+        std::atomic<uint64_t> batches_{0};
+        std::atomic<uint64_t> duplicates_{0};
+        std::atomic<uint64_t> max_batch_{0};
+    };
+
+}
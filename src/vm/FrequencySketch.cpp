@@ -0,0 +1,146 @@
+#include "FrequencySketch.h"
+
+namespace uvm_sim
+{
+
+    namespace
+    {
+        constexpr uint64_t ROW_SEEDS[4] = {0x97cb3127ULL, 0xb7b3c2f1ULL, 0x5ac7a8e5ULL, 0xd13e6b27ULL};
+
+        inline uint64_t mix64(uint64_t x)
+        {
+            x ^= x >> 33;
+            x *= 0xff51afd7ed558ccdULL;
+            x ^= x >> 33;
+            x *= 0xc4ceb9fe1a85ec53ULL;
+            x ^= x >> 33;
+            return x;
+        }
+
+        inline size_t next_power_of_two(size_t n)
+        {
+            size_t p = 1;
+            while (p < n)
+            {
+                p <<= 1;
+            }
+            return p;
+        }
+    }
+
+    
+    
+    
+
+    FrequencySketch::FrequencySketch(size_t capacity) : additions_(0)
+    {
+        size_t num_counters = next_power_of_two(std::max<size_t>(capacity * 4, 64));
+        table_.assign(num_counters / 16, 0);
+        counter_mask_ = num_counters - 1;
+        sample_size_ = std::max<uint64_t>(capacity * 10, 64);
+    }
+
+    size_t FrequencySketch::counter_index(VirtualPageNumber vpn, int row) const
+    {
+        return mix64(vpn * ROW_SEEDS[row] + row) & counter_mask_;
+    }
+
+    uint32_t FrequencySketch::read_counter(size_t idx) const
+    {
+        return (table_[idx >> 4] >> ((idx & 15) << 2)) & 0xF;
+    }
+
+    bool FrequencySketch::increment_counter(size_t idx)
+    {
+        uint64_t &word = table_[idx >> 4];
+        int shift = (idx & 15) << 2;
+        if (((word >> shift) & 0xF) == MAX_COUNT)
+        {
+            return false;
+        }
+        word += (1ULL << shift);
+        return true;
+    }
+
+    void FrequencySketch::increment(VirtualPageNumber vpn)
+    {
+        bool added = false;
+        for (int row = 0; row < DEPTH; row++)
+        {
+            added |= increment_counter(counter_index(vpn, row));
+        }
+
+        if (added && ++additions_ >= sample_size_)
+        {
+            halve();
+        }
+    }
+
+    uint32_t FrequencySketch::frequency(VirtualPageNumber vpn) const
+    {
+        uint32_t freq = MAX_COUNT;
+        for (int row = 0; row < DEPTH; row++)
+        {
+            freq = std::min(freq, read_counter(counter_index(vpn, row)));
+        }
+        return freq;
+    }
+
+    void FrequencySketch::halve()
+    {
+        for (auto &word : table_)
+        {
+            word = (word >> 1) & 0x7777777777777777ULL;
+        }
+        additions_ /= 2;
+    }
+
+    void FrequencySketch::clear()
+    {
+        std::fill(table_.begin(), table_.end(), 0);
+        additions_ = 0;
+    }
+
+    
+    
+    
+
+    TinyLFUAdmissionFilter::TinyLFUAdmissionFilter(size_t gpu_frames)
+        : sketch_(gpu_frames), admitted_(0), rejected_(0)
+    {
+        LOG_DEBUG("TinyLFU admission filter: %zu frames, %zu bytes of counters", gpu_frames, sketch_.size_bytes());
+    }
+
+    void TinyLFUAdmissionFilter::record_access(VirtualPageNumber vpn)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sketch_.increment(vpn);
+    }
+
+    bool TinyLFUAdmissionFilter::admit(VirtualPageNumber candidate, VirtualPageNumber victim)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (sketch_.frequency(candidate) > sketch_.frequency(victim))
+        {
+            admitted_++;
+            return true;
+        }
+        rejected_++;
+        return false;
+    }
+
+    uint32_t TinyLFUAdmissionFilter::estimate(VirtualPageNumber vpn) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sketch_.frequency(vpn);
+    }
+
+    void TinyLFUAdmissionFilter::reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sketch_.clear();
+        admitted_ = 0;
+        rejected_ = 0;
+    }
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Common.h"
+
+namespace uvm_sim
+{
+
+    // Count-min sketch with 4-bit saturating counters packed sixteen to a word.
+    // Counters are halved every sample_size increments so the estimate tracks
+    // recent popularity rather than all-time totals.
+    class FrequencySketch
+    {
+    public:
+        explicit FrequencySketch(size_t capacity);
+
+        void increment(VirtualPageNumber vpn);
+
+        uint32_t frequency(VirtualPageNumber vpn) const;
+
+        void clear();
+
+        size_t size_bytes() const { return table_.size() * sizeof(uint64_t); }
+        uint64_t get_sample_size() const { return sample_size_; }
+
+    private:
+        static constexpr int DEPTH = 4;
+        static constexpr uint32_t MAX_COUNT = 15;
+
+        std::vector<uint64_t> table_;
+        uint64_t counter_mask_;
+        uint64_t sample_size_;
+        uint64_t additions_;
+
+        size_t counter_index(VirtualPageNumber vpn, int row) const;
+        uint32_t read_counter(size_t idx) const;
+        bool increment_counter(size_t idx);
+        void halve();
+    };
+
+    // TinyLFU admission: a page that needs a GPU frame may only displace the
+    // replacement policy's victim if it has been accessed more often recently.
+    class TinyLFUAdmissionFilter
+    {
+    public:
+        explicit TinyLFUAdmissionFilter(size_t gpu_frames);
+
+        void record_access(VirtualPageNumber vpn);
+
+        bool admit(VirtualPageNumber candidate, VirtualPageNumber victim);
+
+        uint32_t estimate(VirtualPageNumber vpn) const;
+
+        uint64_t get_admitted() const { return admitted_; }
+        uint64_t get_rejected() const { return rejected_; }
+        size_t size_bytes() const { return sketch_.size_bytes(); }
+
+        void reset();
+
+    private:
+        FrequencySketch sketch_;
+        uint64_t admitted_;
+        uint64_t rejected_;
+        mutable std::mutex mutex_;
+    };
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Common.h"
+#include <cstring>
+
+namespace uvm_sim
+{
+
+    enum class MigrationDirection : uint8_t
+    {
+        HOST_TO_DEVICE = 0,
+        DEVICE_TO_HOST = 1
+    };
+
+    enum class LinkCompression : uint8_t
+    {
+        NONE = 0,
+        PATTERN = 1 // 64-byte blocks holding one repeated 8-byte word travel as that word
+    };
+
+    // Wire size under LinkCompression::PATTERN: one tag bit per 64-byte
+    // block, then 8 bytes for a uniform block or the raw block otherwise.
+    // Catches zeroed and constant-filled data at memory-scan speed.
+    inline size_t pattern_compressed_size(const uint8_t *data, size_t bytes)
+    {
+        constexpr size_t BLOCK = 64;
+        size_t blocks = bytes / BLOCK;
+        size_t wire = (blocks + 7) / 8 + (bytes - blocks * BLOCK);
+        for (size_t b = 0; b < blocks; b++)
+        {
+            uint64_t words[BLOCK / 8];
+            std::memcpy(words, data + b * BLOCK, BLOCK);
+            bool uniform = true;
+            for (size_t w = 1; w < BLOCK / 8 && uniform; w++)
+            {
+                uniform = words[w] == words[0];
+            }
+            wire += uniform ? 8 : BLOCK;
+        }
+        return wire;
+    }
+
+    
+    
+    
+
+    // Per-direction latency + bandwidth model of the host<->device link.
+    // Bandwidth is in GB/s, i.e. bytes per nanosecond.
+    struct LinkModel
+    {
+        const char *name = "PCIe Gen4 x16";
+        double h2d_bandwidth_gbps = 25.0;
+        double d2h_bandwidth_gbps = 26.0;
+        uint64_t h2d_latency_ns = 8000;
+        uint64_t d2h_latency_ns = 8000;
+
+        uint64_t transfer_time_ns(size_t bytes, MigrationDirection dir) const
+        {
+            bool h2d = dir == MigrationDirection::HOST_TO_DEVICE;
+            double bandwidth = h2d ? h2d_bandwidth_gbps : d2h_bandwidth_gbps;
+            uint64_t latency = h2d ? h2d_latency_ns : d2h_latency_ns;
+            return latency + (uint64_t)((double)bytes / bandwidth);
+        }
+
+        static LinkModel pcie_gen3_x16() { return {"PCIe Gen3 x16", 12.0, 13.0, 10000, 10000}; }
+        static LinkModel pcie_gen4_x16() { return {"PCIe Gen4 x16", 25.0, 26.0, 8000, 8000}; }
+        static LinkModel pcie_gen5_x16() { return {"PCIe Gen5 x16", 50.0, 52.0, 6000, 6000}; }
+        static LinkModel nvlink2() { return {"NVLink 2.0", 68.0, 68.0, 3000, 3000}; }
+        static LinkModel nvlink_c2c() { return {"NVLink-C2C", 400.0, 400.0, 1000, 1000}; }
+    };
+
+}
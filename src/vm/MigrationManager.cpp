@@ -2,32 +2,50 @@
 #include <thread>
 #include <chrono>
 #include <cstring>
+#include <algorithm>
 
 namespace uvm_sim
 {
 
-    MigrationManager::MigrationManager(PageTable *page_table, const Config &config)
-        : page_table_(page_table), config_(config)
+    MigrationManager::MigrationManager(PageTable *page_table, PageAllocator *allocator, const Config &config)
+        : page_table_(page_table), allocator_(allocator), config_(config)
     {
         if (config_.async_migration)
         {
-            for (size_t i = 0; i < config_.max_concurrent_migrations; i++)
+            size_t num_slots = config_.queue_capacity * NUM_MIGRATION_PRIORITIES *
+                               (config_.h2d_copy_engines + config_.d2h_copy_engines);
+            slots_.reset(new CompletionSlot[num_slots]);
+            free_slots_ = std::make_unique<MPMCQueue<uint32_t>>(num_slots);
+            for (uint32_t i = 0; i < num_slots; i++)
             {
-                migration_workers_.emplace_back(&MigrationManager::migration_worker_thread, this);
+                free_slots_->try_push(i);
+            }
+
+            auto executor = [this](const MigrationDescriptor &desc)
+            { return execute(desc); };
+            auto on_complete = [this](const MigrationDescriptor &desc, uint64_t time_us)
+            { complete(desc, time_us); };
+            auto urgent = [this]()
+            { return writeback_urgent(); };
+            for (size_t i = 0; i < config_.h2d_copy_engines; i++)
+            {
+                engines_[(int)MigrationDirection::HOST_TO_DEVICE].push_back(std::make_unique<CopyEngine>(
+                    MigrationDirection::HOST_TO_DEVICE, i, config_.queue_capacity, executor, on_complete, urgent));
+            }
+            for (size_t i = 0; i < config_.d2h_copy_engines; i++)
+            {
+                engines_[(int)MigrationDirection::DEVICE_TO_HOST].push_back(std::make_unique<CopyEngine>(
+                    MigrationDirection::DEVICE_TO_HOST, i, config_.queue_capacity, executor, on_complete, urgent));
             }
         }
     }
 
     MigrationManager::~MigrationManager()
     {
-        shutdown_ = true;
-        queue_cv_.notify_all();
-        for (auto &worker : migration_workers_)
+        // Engines drain their queues before their threads join.
+        for (auto &engines : engines_)
         {
-            if (worker.joinable())
-            {
-                worker.join();
-            }
+            engines.clear();
         }
     }
 
@@ -37,156 +55,486 @@ namespace uvm_sim
         if (!cpu_addr)
             return 0;
 
-        
-        uint64_t start_us = get_timestamp_us();
+        uint64_t time_us = enqueue({vpn, cpu_addr, gpu_addr, page_size, 0, 0, 0,
+                                    MigrationDirection::HOST_TO_DEVICE, MigrationPriority::DEMAND})
+                               .get();
+        apply({vpn, cpu_addr, gpu_addr}, MigrationDirection::HOST_TO_DEVICE);
+        return time_us;
+    }
 
-        
-        
-        
-        if (!page_table_->lookup_entry(vpn))
-        {
-            
+    uint64_t MigrationManager::migrate_gpu_to_cpu(VirtualPageNumber vpn, uint64_t gpu_addr,
+                                                  void *cpu_addr, size_t page_size)
+    {
+        if (!cpu_addr || !gpu_addr)
             return 0;
+
+        uint64_t time_us = enqueue({vpn, cpu_addr, gpu_addr, page_size, 0, 0, 0,
+                                    MigrationDirection::DEVICE_TO_HOST, MigrationPriority::DEMAND})
+                               .get();
+        apply({vpn, cpu_addr, gpu_addr}, MigrationDirection::DEVICE_TO_HOST);
+        return time_us;
+    }
+
+    uint64_t MigrationManager::copy_cpu_to_gpu(VirtualPageNumber vpn, void *cpu_addr,
+                                               uint64_t gpu_addr, size_t bytes)
+    {
+        uint8_t *gpu_ptr = allocator_ ? allocator_->gpu_page_ptr(gpu_addr) : nullptr;
+        if (gpu_ptr)
+        {
+            std::memcpy(gpu_ptr, cpu_addr, bytes);
         }
 
-        
-        uint64_t estimated_us = page_size / 1000; 
+        uint64_t time_us = charge_transfer(bytes, wire_size(cpu_addr, bytes), MigrationDirection::HOST_TO_DEVICE);
+        LOG_DEBUG("Migrated VPN=%lu CPU->GPU (%zu bytes) in %lu us", vpn, bytes, time_us);
+        return time_us;
+    }
 
-        std::this_thread::sleep_for(std::chrono::microseconds(1)); 
+    uint64_t MigrationManager::copy_gpu_to_cpu(VirtualPageNumber vpn, uint64_t gpu_addr,
+                                               void *cpu_addr, size_t bytes)
+    {
+        uint8_t *gpu_ptr = allocator_ ? allocator_->gpu_page_ptr(gpu_addr) : nullptr;
+        if (gpu_ptr)
+        {
+            std::memcpy(cpu_addr, gpu_ptr, bytes);
+        }
 
-        uint64_t end_us = get_timestamp_us();
-        uint64_t actual_time_us = end_us - start_us;
+        uint64_t time_us = charge_transfer(bytes, wire_size(gpu_ptr, bytes), MigrationDirection::DEVICE_TO_HOST);
+        LOG_DEBUG("Migrated VPN=%lu GPU->CPU (%zu bytes) in %lu us", vpn, bytes, time_us);
+        return time_us;
+    }
 
-        if (page_table_)
+    void MigrationManager::apply(const PageTransfer &page, MigrationDirection dir)
+    {
+        auto entry = page_table_->lookup_entry(page.vpn);
+        if (!entry)
         {
-            auto entry = page_table_->lookup_entry(vpn);
-            if (entry)
-            {
-                entry->resident_on_gpu = true;
-                entry->gpu_address = gpu_addr;
-                entry->is_dirty = false;
-            }
+            return;
         }
 
-        LOG_DEBUG("Migrated page VPN=%lu CPU->GPU (%zu bytes) in %lu us", vpn, page_size, actual_time_us);
-        return actual_time_us;
+        if (dir == MigrationDirection::HOST_TO_DEVICE)
+        {
+            entry->resident_on_gpu = true;
+            entry->gpu_address = page.gpu_addr;
+            entry->cpu_dirty = false;
+            entry->cpu_dirty_granules = 0;
+        }
+        else
+        {
+            entry->resident_on_cpu = true;
+            entry->cpu_address = page.cpu_addr;
+            entry->gpu_dirty = false;
+            entry->gpu_dirty_granules = 0;
+        }
     }
 
-    uint64_t MigrationManager::migrate_gpu_to_cpu(VirtualPageNumber vpn, uint64_t gpu_addr,
-                                                  void *cpu_addr, size_t page_size)
+    MigrationManager::BatchResult MigrationManager::migrate_batch_cpu_to_gpu(std::vector<PageTransfer> pages,
+                                                                             size_t page_size)
     {
-        if (!cpu_addr || !gpu_addr)
-            return 0;
+        return migrate_batch(pages, page_size, MigrationDirection::HOST_TO_DEVICE);
+    }
 
-        uint64_t start_us = get_timestamp_us();
+    MigrationManager::BatchResult MigrationManager::migrate_batch_gpu_to_cpu(std::vector<PageTransfer> pages,
+                                                                             size_t page_size)
+    {
+        return migrate_batch(pages, page_size, MigrationDirection::DEVICE_TO_HOST);
+    }
 
-        
-        
+    MigrationManager::BatchResult MigrationManager::migrate_batch(std::vector<PageTransfer> &pages, size_t page_size,
+                                                                  MigrationDirection dir)
+    {
+        BatchResult result = submit_batch(pages, page_size, dir, MigrationPriority::DEMAND).wait();
+        for (const auto &page : pages)
+        {
+            apply(page, dir);
+        }
+        return result;
+    }
 
-        if (page_table_)
+    MigrationManager::PendingBatch MigrationManager::submit_batch(std::vector<PageTransfer> pages, size_t page_size,
+                                                                  MigrationDirection dir, MigrationPriority priority)
+    {
+        PendingBatch batch;
+        bool h2d = dir == MigrationDirection::HOST_TO_DEVICE;
+
+        std::sort(pages.begin(), pages.end(), [](const PageTransfer &a, const PageTransfer &b)
+                  { return a.vpn < b.vpn; });
+
+        size_t run_start = 0;
+        while (run_start < pages.size())
         {
-            auto entry = page_table_->lookup_entry(vpn);
-            if (entry)
+            // Extend the run while pages are contiguous in VPN, host and device address.
+            size_t run_end = run_start + 1;
+            while (run_end < pages.size())
             {
-                entry->resident_on_cpu = true;
-                entry->cpu_address = cpu_addr;
+                const PageTransfer &prev = pages[run_end - 1];
+                const PageTransfer &next = pages[run_end];
+                if (next.vpn != prev.vpn + 1 ||
+                    static_cast<uint8_t *>(next.cpu_addr) != static_cast<uint8_t *>(prev.cpu_addr) + page_size ||
+                    next.gpu_addr != prev.gpu_addr + page_size)
+                {
+                    break;
+                }
+                run_end++;
             }
+
+            // Runs are not tracked per VPN: the submitter owns every page in them.
+            const PageTransfer &first = pages[run_start];
+            size_t run_bytes = (run_end - run_start) * page_size;
+            batch.runs.push_back(enqueue({first.vpn, first.cpu_addr, first.gpu_addr, run_bytes, 0, 0, 0, dir, priority},
+                                         false));
+
+            batch.result.runs++;
+            batch.result.pages += run_end - run_start;
+            batch.result.bytes += run_bytes;
+            run_start = run_end;
         }
 
-        std::this_thread::sleep_for(std::chrono::microseconds(1));
+        LOG_DEBUG("Submitted %zu pages %s in %zu runs (%zu bytes)", batch.result.pages,
+                  h2d ? "CPU->GPU" : "GPU->CPU", batch.result.runs, batch.result.bytes);
+        return batch;
+    }
 
-        uint64_t end_us = get_timestamp_us();
-        uint64_t actual_time_us = end_us - start_us;
+    MigrationManager::BatchResult MigrationManager::PendingBatch::wait()
+    {
+        result.time_us = 0;
+        for (auto &run : runs)
+        {
+            result.time_us += run.get();
+        }
+        return result;
+    }
 
-        LOG_DEBUG("Migrated page VPN=%lu GPU->CPU (%zu bytes) in %lu us", vpn, page_size, actual_time_us);
-        return actual_time_us;
+    // Calls fn(offset, bytes) for each run of consecutive set bits in `granules`.
+    template <typename Fn>
+    static void for_each_granule_run(uint64_t granules, size_t granule_size, Fn fn)
+    {
+        for (size_t first = 0; first < 64; first++)
+        {
+            if (!(granules & (1ULL << first)))
+            {
+                continue;
+            }
+            size_t last = first;
+            while (last + 1 < 64 && (granules & (1ULL << (last + 1))))
+            {
+                last++;
+            }
+            fn(first * granule_size, (last - first + 1) * granule_size);
+            first = last;
+        }
     }
 
-    void MigrationManager::async_migrate_cpu_to_gpu(VirtualPageNumber vpn, void *cpu_addr,
-                                                    uint64_t gpu_addr, size_t page_size)
+    MigrationManager::BatchResult MigrationManager::migrate_granules(const PageTransfer &page, size_t granule_size,
+                                                                     uint64_t granules, MigrationDirection dir)
     {
-        auto migration_fn = [this, vpn, cpu_addr, gpu_addr, page_size]()
+        BatchResult result;
+        if (granules == 0)
         {
-            migrate_cpu_to_gpu(vpn, cpu_addr, gpu_addr, page_size);
-        };
+            return result;
+        }
+
+        bool h2d = dir == MigrationDirection::HOST_TO_DEVICE;
+        for_each_granule_run(granules, granule_size, [&result](size_t, size_t run_bytes)
+                             {
+                                 result.runs++;
+                                 result.bytes += run_bytes;
+                             });
+        result.pages = 1;
 
+        // The caller holds the page lock, so no other transfer of it is in flight.
+        MigrationDescriptor desc{page.vpn, page.cpu_addr, page.gpu_addr, result.bytes, 0, 0, 0, dir,
+                                 MigrationPriority::DEMAND};
+        desc.granules = granules;
+        desc.granule_size = (uint32_t)granule_size;
+        result.time_us = enqueue(desc, false).get();
+
+        auto entry = page_table_->lookup_entry(page.vpn);
+        if (entry)
         {
-            std::lock_guard<std::mutex> lock(queue_mutex_);
-            migration_queue_.push({vpn, migration_fn});
+            if (h2d)
+            {
+                entry->cpu_dirty = false;
+                entry->cpu_dirty_granules = 0;
+            }
+            else
+            {
+                entry->gpu_dirty = false;
+                entry->gpu_dirty_granules = 0;
+            }
         }
-        queue_cv_.notify_one();
+
+        LOG_DEBUG("Delta-migrated VPN=%lu %s (%zu bytes in %zu runs)", page.vpn, h2d ? "CPU->GPU" : "GPU->CPU",
+                  result.bytes, result.runs);
+        return result;
+    }
+
+    uint64_t MigrationManager::copy_granules(const MigrationDescriptor &desc)
+    {
+        bool h2d = desc.direction == MigrationDirection::HOST_TO_DEVICE;
+        uint8_t *cpu_ptr = static_cast<uint8_t *>(desc.cpu_addr);
+        uint8_t *gpu_ptr = allocator_ ? allocator_->gpu_page_ptr(desc.gpu_addr) : nullptr;
+        const uint8_t *src = h2d ? cpu_ptr : gpu_ptr;
+        size_t wire_bytes = 0;
+
+        for_each_granule_run(desc.granules, desc.granule_size, [&](size_t offset, size_t run_bytes)
+                             {
+                                 if (gpu_ptr)
+                                 {
+                                     if (h2d)
+                                         std::memcpy(gpu_ptr + offset, cpu_ptr + offset, run_bytes);
+                                     else
+                                         std::memcpy(cpu_ptr + offset, gpu_ptr + offset, run_bytes);
+                                 }
+                                 wire_bytes += wire_size(src ? src + offset : nullptr, run_bytes);
+                             });
+
+        // All runs of the page go out as one scatter-gather transfer.
+        return charge_transfer(desc.bytes, wire_bytes, desc.direction);
     }
 
-    void MigrationManager::async_migrate_gpu_to_cpu(VirtualPageNumber vpn, uint64_t gpu_addr,
-                                                    void *cpu_addr, size_t page_size)
+    size_t MigrationManager::wire_size(const void *src, size_t bytes) const
     {
-        auto migration_fn = [this, vpn, gpu_addr, cpu_addr, page_size]()
+        if (config_.compression == LinkCompression::NONE || !src)
         {
-            migrate_gpu_to_cpu(vpn, gpu_addr, cpu_addr, page_size);
-        };
+            return bytes;
+        }
+        return pattern_compressed_size(static_cast<const uint8_t *>(src), bytes);
+    }
+
+    uint64_t MigrationManager::charge_transfer(size_t bytes, size_t wire_bytes, MigrationDirection dir)
+    {
+        uint64_t modeled_ns = config_.link.transfer_time_ns(bytes, dir);
 
+        // Compressed data pays the codec on both ends; send raw when that is not a win.
+        if (wire_bytes < bytes)
         {
-            std::lock_guard<std::mutex> lock(queue_mutex_);
-            migration_queue_.push({vpn, migration_fn});
+            uint64_t codec_ns = (uint64_t)((double)bytes / config_.codec_bandwidth_gbps);
+            uint64_t compressed_ns = config_.link.transfer_time_ns(wire_bytes, dir) + codec_ns;
+            if (compressed_ns < modeled_ns)
+            {
+                modeled_ns = compressed_ns;
+                stats_[(int)dir].compressed++;
+            }
+            else
+            {
+                wire_bytes = bytes;
+            }
         }
-        queue_cv_.notify_one();
+        wire_bytes = std::min(wire_bytes, bytes);
+
+        DirectionStats &stats = stats_[(int)dir];
+        stats.transfers++;
+        stats.bytes += bytes;
+        stats.modeled_ns += modeled_ns;
+        stats.wire_bytes += wire_bytes;
+
+        if (config_.emulate_transfer_time)
+        {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(modeled_ns);
+            while (std::chrono::steady_clock::now() < deadline)
+            {
+            }
+        }
+
+        return (modeled_ns + 999) / 1000;
     }
 
-    void MigrationManager::wait_for_migrations()
+    double MigrationManager::get_compression_ratio(MigrationDirection dir) const
     {
-        
-        while (true)
+        uint64_t wire = stats_[(int)dir].wire_bytes;
+        return wire ? (double)stats_[(int)dir].bytes / (double)wire : 1.0;
+    }
+
+    double MigrationManager::get_modeled_bandwidth_gbps(MigrationDirection dir) const
+    {
+        uint64_t ns = stats_[(int)dir].modeled_ns;
+        return ns ? (double)stats_[(int)dir].bytes / (double)ns : 0.0;
+    }
+
+    MigrationFuture MigrationManager::async_migrate_cpu_to_gpu(VirtualPageNumber vpn, void *cpu_addr,
+                                                               uint64_t gpu_addr, size_t page_size,
+                                                               MigrationPriority priority)
+    {
+        return enqueue({vpn, cpu_addr, gpu_addr, page_size, 0, 0, 0, MigrationDirection::HOST_TO_DEVICE, priority});
+    }
+
+    MigrationFuture MigrationManager::async_migrate_gpu_to_cpu(VirtualPageNumber vpn, uint64_t gpu_addr,
+                                                               void *cpu_addr, size_t page_size,
+                                                               MigrationPriority priority)
+    {
+        return enqueue({vpn, cpu_addr, gpu_addr, page_size, 0, 0, 0, MigrationDirection::DEVICE_TO_HOST, priority});
+    }
+
+    MigrationFuture MigrationManager::enqueue(MigrationDescriptor desc, bool track_in_flight)
+    {
+        // Managers without copy engines, and overflow when every ring or
+        // completion slot is taken, copy on the caller's thread.
+        CopyEngine *engine = select_engine(desc.direction);
+        uint32_t slot = 0;
+        if (engine && !free_slots_->try_pop(slot))
         {
+            engine = nullptr;
+        }
+
+        std::promise<uint64_t> local_promise;
+        std::promise<uint64_t> &promise = engine ? slots_[slot].promise : local_promise;
+        promise = std::promise<uint64_t>();
+        MigrationFuture future = promise.get_future().share();
+
+        // A request for a page already moving the same way attaches to that transfer;
+        // one moving the opposite way waits for it to land first.
+        while (track_in_flight)
+        {
+            MigrationFuture predecessor;
             {
-                std::lock_guard<std::mutex> lock(queue_mutex_);
-                if (migration_queue_.empty())
+                std::lock_guard<std::mutex> lock(in_flight_mutex_);
+                auto it = in_flight_pages_.find(desc.vpn);
+                if (it == in_flight_pages_.end())
                 {
+                    desc.ticket = ++next_ticket_;
+                    in_flight_pages_.emplace(desc.vpn, InFlightMigration{desc.direction, desc.ticket, future});
                     break;
                 }
+                if (it->second.direction == desc.direction)
+                {
+                    deduplicated_++;
+                    if (engine)
+                    {
+                        free_slots_->try_push(slot);
+                    }
+                    return it->second.done;
+                }
+                predecessor = it->second.done;
+            }
+            predecessor.wait();
+        }
+
+        if (engine)
+        {
+            desc.completion_slot = slot;
+            pending_.fetch_add(1, std::memory_order_acq_rel);
+            if (engine->try_submit(desc))
+            {
+                return future;
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            pending_.fetch_sub(1, std::memory_order_acq_rel);
+        }
+
+        uint64_t time_us = execute(desc);
+        if (track_in_flight)
+        {
+            retire(desc.vpn, desc.ticket);
         }
+        promise.set_value(time_us);
+        if (engine)
+        {
+            free_slots_->try_push(slot);
+        }
+        return future;
     }
 
-    size_t MigrationManager::get_pending_migrations() const
+    uint64_t MigrationManager::execute(const MigrationDescriptor &desc)
+    {
+        if (desc.granules)
+        {
+            return copy_granules(desc);
+        }
+        if (desc.direction == MigrationDirection::HOST_TO_DEVICE)
+        {
+            return copy_cpu_to_gpu(desc.vpn, desc.cpu_addr, desc.gpu_addr, desc.bytes);
+        }
+        return copy_gpu_to_cpu(desc.vpn, desc.gpu_addr, desc.cpu_addr, desc.bytes);
+    }
+
+    void MigrationManager::complete(const MigrationDescriptor &desc, uint64_t time_us)
     {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        return migration_queue_.size();
+        if (desc.ticket)
+        {
+            retire(desc.vpn, desc.ticket);
+        }
+        slots_[desc.completion_slot].promise.set_value(time_us);
+        free_slots_->try_push(desc.completion_slot);
+
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            completion_cv_.notify_all();
+        }
     }
 
-    void MigrationManager::migration_worker_thread()
+    void MigrationManager::retire(VirtualPageNumber vpn, uint64_t ticket)
     {
-        while (!shutdown_)
+        std::lock_guard<std::mutex> lock(in_flight_mutex_);
+        auto it = in_flight_pages_.find(vpn);
+        if (it != in_flight_pages_.end() && it->second.ticket == ticket)
         {
-            std::pair<VirtualPageNumber, std::function<void()>> migration_job;
+            in_flight_pages_.erase(it);
+        }
+    }
 
+    bool MigrationManager::is_in_flight(VirtualPageNumber vpn) const
+    {
+        std::lock_guard<std::mutex> lock(in_flight_mutex_);
+        return in_flight_pages_.count(vpn) > 0;
+    }
+
+    CopyEngine *MigrationManager::select_engine(MigrationDirection dir) const
+    {
+        CopyEngine *best = nullptr;
+        size_t best_depth = 0;
+        for (const auto &engine : engines_[(int)dir])
+        {
+            size_t depth = engine->get_queue_depth();
+            if (!best || depth < best_depth)
             {
-                std::unique_lock<std::mutex> lock(queue_mutex_);
-                queue_cv_.wait(lock, [this]()
-                               { return !migration_queue_.empty() || shutdown_; });
+                best = engine.get();
+                best_depth = depth;
+            }
+        }
+        return best;
+    }
 
-                if (shutdown_ && migration_queue_.empty())
-                {
-                    break;
-                }
+    bool MigrationManager::writeback_urgent() const
+    {
+        return allocator_ && allocator_->get_available_gpu_pages() < config_.free_frame_reserve;
+    }
 
-                if (!migration_queue_.empty())
-                {
-                    migration_job = migration_queue_.front();
-                    migration_queue_.pop();
-                }
-                else
-                {
-                    continue;
-                }
+    void MigrationManager::wait_for_migrations()
+    {
+        std::unique_lock<std::mutex> lock(pending_mutex_);
+        completion_cv_.wait(lock, [this]()
+                            { return pending_.load(std::memory_order_acquire) == 0; });
+    }
+
+    size_t MigrationManager::get_pending_migrations() const
+    {
+        return pending_.load(std::memory_order_acquire);
+    }
+
+    size_t MigrationManager::get_queued_migrations() const
+    {
+        size_t queued = 0;
+        for (const auto &engines : engines_)
+        {
+            for (const auto &engine : engines)
+            {
+                queued += engine->get_queued();
             }
+        }
+        return queued;
+    }
 
-            
-            if (migration_job.second)
+    size_t MigrationManager::get_in_flight_migrations() const
+    {
+        size_t in_flight = 0;
+        for (const auto &engines : engines_)
+        {
+            for (const auto &engine : engines)
             {
-                migration_job.second();
+                in_flight += engine->is_busy() ? 1 : 0;
             }
         }
+        return in_flight;
     }
 
-} 
+}
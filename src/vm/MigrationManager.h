@@ -2,48 +2,190 @@
 
 #include "Common.h"
 #include "PageTable.h"
+#include "PageAllocator.h"
+#include "LinkModel.h"
+#include "CopyEngine.h"
+#include <functional>
+#include <future>
 
 namespace uvm_sim
 {
+    // Resolves to the modeled transfer time in microseconds once the copy has finished.
+    using MigrationFuture = std::shared_future<uint64_t>;
+
     class MigrationManager
     {
     public:
         struct Config
         {
             bool async_migration = true;
-            size_t max_concurrent_migrations = 4;
-            
+            size_t h2d_copy_engines = 2;
+            size_t d2h_copy_engines = 2;
+            size_t free_frame_reserve = 0; // writebacks overtake prefetches below this many free GPU frames
+            size_t queue_capacity = 1024;  // ring slots per priority per copy engine
+            LinkModel link = LinkModel::pcie_gen4_x16();
+            bool emulate_transfer_time = false; // busy-wait for the modeled transfer time
+            LinkCompression compression = LinkCompression::NONE;
+            double codec_bandwidth_gbps = 32.0; // compress + decompress throughput, bytes per ns
+        };
+
+        struct PageTransfer
+        {
+            VirtualPageNumber vpn;
+            void *cpu_addr;
+            uint64_t gpu_addr;
+        };
+
+        struct BatchResult
+        {
+            size_t pages = 0;
+            size_t runs = 0; // copies issued after coalescing contiguous pages
+            size_t bytes = 0;
+            uint64_t time_us = 0;
         };
 
-        explicit MigrationManager(PageTable *page_table, const Config &config = Config());
+        // Batch copy running on the copy engines. Only data moves; the page
+        // table is the submitter's to update once wait() returns.
+        struct PendingBatch
+        {
+            BatchResult result; // time_us is filled in by wait()
+            std::vector<MigrationFuture> runs;
+
+            BatchResult wait();
+        };
+
+        MigrationManager(PageTable *page_table, PageAllocator *allocator, const Config &config = Config());
         ~MigrationManager();
 
-        
+        // Blocking copies. They run on the copy engines at DEMAND priority when
+        // there are any, and the page table is updated on the calling thread,
+        // which is expected to hold the pages' locks.
         uint64_t migrate_cpu_to_gpu(VirtualPageNumber vpn, void *cpu_addr, uint64_t gpu_addr, size_t page_size);
-
-        
         uint64_t migrate_gpu_to_cpu(VirtualPageNumber vpn, uint64_t gpu_addr, void *cpu_addr, size_t page_size);
 
         
-        void async_migrate_cpu_to_gpu(VirtualPageNumber vpn, void *cpu_addr, uint64_t gpu_addr, size_t page_size);
-        void async_migrate_gpu_to_cpu(VirtualPageNumber vpn, uint64_t gpu_addr, void *cpu_addr, size_t page_size);
+        BatchResult migrate_batch_cpu_to_gpu(std::vector<PageTransfer> pages, size_t page_size);
+        BatchResult migrate_batch_gpu_to_cpu(std::vector<PageTransfer> pages, size_t page_size);
+
+        // Starts a batch at `priority`, one engine job per contiguous run, and
+        // returns without waiting or touching the page table.
+        PendingBatch submit_batch(std::vector<PageTransfer> pages, size_t page_size, MigrationDirection dir,
+                                  MigrationPriority priority);
+
+        // Delta copy between the two copies of one page: only granules set in
+        // `granules` (bit i covers [i * granule_size, (i + 1) * granule_size))
+        // are copied, as one scatter-gather job at DEMAND priority. The dirty
+        // bits are cleared on the calling thread, which holds the page lock.
+        BatchResult migrate_granules(const PageTransfer &page, size_t granule_size, uint64_t granules,
+                                     MigrationDirection dir);
+
+        // Copy data only; the caller updates the page table once the future is
+        // ready. A request for a VPN that already has a transfer in flight in the
+        // same direction returns that transfer's future and its addresses win.
+        // VirtualMemoryManager never has two transfers of one page in flight, as
+        // each runs under the page lock or with the page marked in transit.
+        MigrationFuture async_migrate_cpu_to_gpu(VirtualPageNumber vpn, void *cpu_addr, uint64_t gpu_addr, size_t page_size,
+                                                 MigrationPriority priority = MigrationPriority::DEMAND);
+        MigrationFuture async_migrate_gpu_to_cpu(VirtualPageNumber vpn, uint64_t gpu_addr, void *cpu_addr, size_t page_size,
+                                                 MigrationPriority priority = MigrationPriority::DEMAND);
 
         
         void wait_for_migrations();
 
         
         size_t get_pending_migrations() const;
+        size_t get_queued_migrations() const;
+        size_t get_in_flight_migrations() const;
+
+        
+        bool is_in_flight(VirtualPageNumber vpn) const;
+        uint64_t get_deduplicated() const { return deduplicated_.load(std::memory_order_relaxed); }
+
+        
+        uint64_t get_transfers(MigrationDirection dir) const { return stats_[(int)dir].transfers; }
+        uint64_t get_bytes_transferred(MigrationDirection dir) const { return stats_[(int)dir].bytes; }
+        uint64_t get_modeled_time_ns(MigrationDirection dir) const { return stats_[(int)dir].modeled_ns; }
+        double get_modeled_bandwidth_gbps(MigrationDirection dir) const;
+        uint64_t get_wire_bytes(MigrationDirection dir) const { return stats_[(int)dir].wire_bytes; }
+        uint64_t get_compressed_transfers(MigrationDirection dir) const { return stats_[(int)dir].compressed; }
+        double get_compression_ratio(MigrationDirection dir) const;
+        const LinkModel &get_link() const { return config_.link; }
+
+        
+        const std::vector<std::unique_ptr<CopyEngine>> &get_copy_engines(MigrationDirection dir) const
+        {
+            return engines_[(int)dir];
+        }
 
     private:
+        struct InFlightMigration
+        {
+            MigrationDirection direction;
+            uint64_t ticket;
+            MigrationFuture done;
+        };
+
+        // Waiter for one queued descriptor; recycled through free_slots_.
+        struct CompletionSlot
+        {
+            std::promise<uint64_t> promise;
+        };
+
+        struct DirectionStats
+        {
+            std::atomic<uint64_t> transfers{0};
+            std::atomic<uint64_t> bytes{0};
+            std::atomic<uint64_t> modeled_ns{0};
+            std::atomic<uint64_t> wire_bytes{0};
+            std::atomic<uint64_t> compressed{0};
+        };
+
         PageTable *page_table_;
+        PageAllocator *allocator_;
         Config config_;
-        std::vector<std::thread> migration_workers_;
-        std::queue<std::pair<VirtualPageNumber, std::function<void()>>> migration_queue_;
-        std::mutex queue_mutex_;
-        std::condition_variable queue_cv_;
-        std::atomic<bool> shutdown_{false};
+        DirectionStats stats_[2];
+        std::vector<std::unique_ptr<CopyEngine>> engines_[2];
+
+        std::unique_ptr<CompletionSlot[]> slots_;
+        std::unique_ptr<MPMCQueue<uint32_t>> free_slots_;
+
+        std::atomic<size_t> pending_{0};
+        std::mutex pending_mutex_;
+        std::condition_variable completion_cv_;
+
+        std::unordered_map<VirtualPageNumber, InFlightMigration> in_flight_pages_;
+        uint64_t next_ticket_ = 0;
+        mutable std::mutex in_flight_mutex_;
+        std::atomic<uint64_t> deduplicated_{0};
+
+        
+        uint64_t copy_cpu_to_gpu(VirtualPageNumber vpn, void *cpu_addr, uint64_t gpu_addr, size_t bytes);
+        uint64_t copy_gpu_to_cpu(VirtualPageNumber vpn, uint64_t gpu_addr, void *cpu_addr, size_t bytes);
+        uint64_t copy_granules(const MigrationDescriptor &desc);
 
-        void migration_worker_thread();
+        // Page table update for a finished copy, on the caller's thread.
+        void apply(const PageTransfer &page, MigrationDirection dir);
+
+        
+        MigrationFuture enqueue(MigrationDescriptor desc, bool track_in_flight = true);
+        void retire(VirtualPageNumber vpn, uint64_t ticket);
+
+        
+        uint64_t execute(const MigrationDescriptor &desc);
+        void complete(const MigrationDescriptor &desc, uint64_t time_us);
+
+        
+        bool writeback_urgent() const;
+
+        
+        CopyEngine *select_engine(MigrationDirection dir) const;
+
+        
+        size_t wire_size(const void *src, size_t bytes) const;
+        uint64_t charge_transfer(size_t bytes, size_t wire_bytes, MigrationDirection dir);
+
+        
+        BatchResult migrate_batch(std::vector<PageTransfer> &pages, size_t page_size, MigrationDirection dir);
     };
 
 } 
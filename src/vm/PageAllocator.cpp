@@ -5,7 +5,7 @@ namespace uvm_sim
 {
 
     PageAllocator::PageAllocator(const Config &config)
-        : config_(config), cpu_pages_allocated_(0), gpu_pages_allocated_(0), cpu_pool_(nullptr)
+        : config_(config), cpu_pages_allocated_(0), gpu_pages_allocated_(0), gpu_pages_pinned_(0), cpu_pool_(nullptr)
     {
     }
 
@@ -61,6 +61,7 @@ namespace uvm_sim
             gpu_pool_.resize(config_.gpu_page_pool_size, 0);
         }
         gpu_page_bitmap_.resize(num_gpu_pages, false);
+        zero_page_.assign(config_.page_size, 0);
 
         LOG_INFO("PageAllocator initialized: CPU=%zu pages, GPU=%zu pages", num_cpu_pages, num_gpu_pages);
     }
@@ -125,7 +126,7 @@ namespace uvm_sim
                 gpu_pages_allocated_++;
 
                 
-                uint64_t gpu_addr = 0x100000000UL + (i * config_.page_size);
+                uint64_t gpu_addr = GPU_ADDRESS_BASE + (i * config_.page_size);
                 LOG_TRACE("Allocated GPU page %zu at 0x%lx", i, gpu_addr);
                 return gpu_addr;
             }
@@ -139,7 +140,7 @@ namespace uvm_sim
     {
         std::lock_guard<std::mutex> lock(mutex_);
 
-        uint64_t base = 0x100000000UL;
+        uint64_t base = GPU_ADDRESS_BASE;
         if (gpu_addr < base)
         {
             LOG_WARN("Invalid GPU address: 0x%lx", gpu_addr);
@@ -155,6 +156,54 @@ namespace uvm_sim
         }
     }
 
+    uint8_t *PageAllocator::gpu_page_ptr(uint64_t gpu_addr)
+    {
+        // Only the simulator backs GPU frames with host memory.
+        if (gpu_pool_.empty() || gpu_addr < GPU_ADDRESS_BASE)
+        {
+            return nullptr;
+        }
+
+        size_t offset = gpu_addr - GPU_ADDRESS_BASE;
+        if (offset + config_.page_size > gpu_pool_.size())
+        {
+            return nullptr;
+        }
+        return gpu_pool_.data() + offset;
+    }
+
+    bool PageAllocator::pin_gpu_page()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (gpu_pages_pinned_ + 1 > get_max_pinned_gpu_pages())
+        {
+            LOG_WARN("Pinned GPU page limit reached (%zu pages)", gpu_pages_pinned_);
+            return false;
+        }
+        gpu_pages_pinned_++;
+        return true;
+    }
+
+    void PageAllocator::unpin_gpu_page()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (gpu_pages_pinned_ > 0)
+        {
+            gpu_pages_pinned_--;
+        }
+    }
+
+    size_t PageAllocator::get_pinned_gpu_pages() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return gpu_pages_pinned_;
+    }
+
+    size_t PageAllocator::get_max_pinned_gpu_pages() const
+    {
+        return (size_t)(gpu_page_bitmap_.size() * config_.max_pinned_gpu_fraction);
+    }
+
     size_t PageAllocator::get_available_cpu_pages() const
     {
         std::lock_guard<std::mutex> lock(mutex_);
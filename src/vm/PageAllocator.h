@@ -12,6 +12,8 @@ namespace uvm_sim
     class PageAllocator
     {
     public:
+        static constexpr uint64_t GPU_ADDRESS_BASE = 0x100000000UL;
+
         struct Config
         {
             size_t page_size = DEFAULT_PAGE_SIZE;
@@ -19,6 +21,7 @@ namespace uvm_sim
             size_t gpu_page_pool_size = DEFAULT_GPU_MEMORY;
             bool use_pinned_memory = true;  
             bool use_gpu_simulator = false; 
+            double max_pinned_gpu_fraction = 0.5;
         };
 
         explicit PageAllocator(const Config &config = Config());
@@ -40,6 +43,12 @@ namespace uvm_sim
         void deallocate_gpu_page(uint64_t gpu_addr);
 
         
+        uint8_t *gpu_page_ptr(uint64_t gpu_addr);
+
+        // Shared read-only frame of zeros mapped by never-written pages.
+        void *get_zero_page() { return zero_page_.data(); }
+
+        
         size_t get_available_cpu_pages() const;
 
         
@@ -52,6 +61,12 @@ namespace uvm_sim
         size_t get_total_gpu_pages() const;
 
         
+        bool pin_gpu_page();
+        void unpin_gpu_page();
+        size_t get_pinned_gpu_pages() const;
+        size_t get_max_pinned_gpu_pages() const;
+
+        
         size_t get_page_size() const { return config_.page_size; }
 
         
@@ -61,6 +76,7 @@ namespace uvm_sim
         Config config_;
         size_t cpu_pages_allocated_;
         size_t gpu_pages_allocated_;
+        size_t gpu_pages_pinned_;
 
         
         void *cpu_pool_;
@@ -70,6 +86,8 @@ namespace uvm_sim
         std::vector<uint8_t> gpu_pool_;
         std::vector<bool> gpu_page_bitmap_; 
 
+        std::vector<uint8_t> zero_page_;
+
         mutable std::mutex mutex_;
     };
 
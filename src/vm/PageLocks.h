@@ -0,0 +1,163 @@
+#pragma once
+
+#include "Common.h"
+#include <array>
+#include <bitset>
+
+namespace uvm_sim
+{
+
+    // Per-page locks for the fault and access paths, striped by VPN onto
+    // cache-line sized mutexes. Each thread remembers which stripes it holds,
+    // which keeps two rules cheap to follow and deadlock-free:
+    //   - blocking acquisition only in ascending stripe order (PageRangeLock);
+    //   - anything else, i.e. eviction victims, is only try-locked (PageLock).
+    // A page whose stripe the thread already holds counts as locked.
+    class PageLockTable
+    {
+    public:
+        static constexpr size_t NUM_STRIPES = 256;
+
+        static size_t stripe_of(VirtualPageNumber vpn) { return vpn & (NUM_STRIPES - 1); }
+
+        bool held(size_t stripe) const { return held_[stripe]; }
+
+        void lock(size_t stripe)
+        {
+            stripes_[stripe].mutex.lock();
+            held_[stripe] = true;
+        }
+
+        bool try_lock(size_t stripe)
+        {
+            if (!stripes_[stripe].mutex.try_lock())
+            {
+                return false;
+            }
+            held_[stripe] = true;
+            return true;
+        }
+
+        void unlock(size_t stripe)
+        {
+            held_[stripe] = false;
+            stripes_[stripe].mutex.unlock();
+        }
+
+    private:
+        struct alignas(64) Stripe
+        {
+            std::mutex mutex;
+        };
+
+        std::array<Stripe, NUM_STRIPES> stripes_;
+        static inline thread_local std::bitset<NUM_STRIPES> held_;
+    };
+
+    
+    
+    
+
+    // Blocks for every stripe covering [vpn_start, vpn_start + num_pages),
+    // skipping stripes this thread already holds.
+    class PageRangeLock
+    {
+    public:
+        PageRangeLock(PageLockTable &table, VirtualPageNumber vpn_start, size_t num_pages)
+            : table_(table)
+        {
+            for (size_t i = 0; i < std::min(num_pages, PageLockTable::NUM_STRIPES); i++)
+            {
+                owned_[PageLockTable::stripe_of(vpn_start + i)] = true;
+            }
+            for (size_t s = 0; s < PageLockTable::NUM_STRIPES; s++)
+            {
+                if (owned_[s] && table_.held(s))
+                {
+                    owned_[s] = false;
+                }
+                else if (owned_[s])
+                {
+                    table_.lock(s);
+                }
+            }
+        }
+
+        ~PageRangeLock()
+        {
+            for (size_t s = 0; s < PageLockTable::NUM_STRIPES; s++)
+            {
+                if (owned_[s])
+                {
+                    table_.unlock(s);
+                }
+            }
+        }
+
+        PageRangeLock(const PageRangeLock &) = delete;
+        PageRangeLock &operator=(const PageRangeLock &) = delete;
+
+    private:
+        PageLockTable &table_;
+        std::bitset<PageLockTable::NUM_STRIPES> owned_;
+    };
+
+    
+    
+    
+
+    // Try-lock on a single page, for pages picked while other locks are held.
+    class PageLock
+    {
+    public:
+        PageLock() = default;
+
+        PageLock(PageLockTable &table, VirtualPageNumber vpn)
+            : table_(&table), stripe_(PageLockTable::stripe_of(vpn))
+        {
+            locked_ = table.held(stripe_);
+            owned_ = !locked_ && table.try_lock(stripe_);
+            locked_ = locked_ || owned_;
+        }
+
+        PageLock(PageLock &&other) noexcept
+            : table_(other.table_), stripe_(other.stripe_), locked_(other.locked_), owned_(other.owned_)
+        {
+            other.locked_ = other.owned_ = false;
+        }
+
+        PageLock &operator=(PageLock &&other) noexcept
+        {
+            if (this != &other)
+            {
+                release();
+                table_ = other.table_;
+                stripe_ = other.stripe_;
+                locked_ = other.locked_;
+                owned_ = other.owned_;
+                other.locked_ = other.owned_ = false;
+            }
+            return *this;
+        }
+
+        ~PageLock() { release(); }
+
+        bool locked() const { return locked_; }
+
+        void release()
+        {
+            if (owned_)
+            {
+                table_->unlock(stripe_);
+            }
+            locked_ = owned_ = false;
+        }
+
+    private:
+        PageLockTable *table_ = nullptr;
+        size_t stripe_ = 0;
+        bool locked_ = false;
+        bool owned_ = false;
+    };
+
+}
@@ -7,7 +7,9 @@ namespace uvm_sim
     {
         std::unique_lock<std::shared_mutex> lock(mutex_);
         entries_.clear();
+        reserved_ranges_.clear();
         num_pages_ = virtual_space_size / page_size_;
+        reset_directory();
         LOG_DEBUG("PageTable initialized: %zu pages (page_size=%zu)", num_pages_, page_size_);
     }
 
@@ -24,17 +26,46 @@ namespace uvm_sim
             }
             entries_[vpn] = PageTableEntry();
             entries_[vpn].is_valid = true;
+            publish(vpn, &entries_[vpn]);
         }
         LOG_DEBUG("Allocated VPN range [%lu, %lu)", vpn_start, vpn_start + num_pages);
         return true;
     }
 
+    bool PageTable::reserve_vpn_range(VirtualPageNumber vpn_start, uint32_t num_pages)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto next = reserved_ranges_.lower_bound(vpn_start);
+        if ((next != reserved_ranges_.end() && next->first < vpn_start + num_pages) ||
+            (next != reserved_ranges_.begin() && std::prev(next)->first + std::prev(next)->second > vpn_start))
+        {
+            LOG_WARN("VPN range [%lu, %lu) overlaps a reservation", vpn_start, vpn_start + num_pages);
+            return false;
+        }
+        reserved_ranges_.emplace_hint(next, vpn_start, num_pages);
+        LOG_DEBUG("Reserved VPN range [%lu, %lu)", vpn_start, vpn_start + num_pages);
+        return true;
+    }
+
+    bool PageTable::is_reserved(VirtualPageNumber vpn) const
+    {
+        auto it = reserved_ranges_.upper_bound(vpn);
+        if (it == reserved_ranges_.begin())
+        {
+            return false;
+        }
+        --it;
+        return vpn < it->first + it->second;
+    }
+
     bool PageTable::deallocate_vpn_range(VirtualPageNumber vpn_start, uint32_t num_pages)
     {
         std::unique_lock<std::shared_mutex> lock(mutex_);
-        for (uint32_t i = 0; i < num_pages; i++)
+        reserved_ranges_.erase(vpn_start);
+        for (uint32_t i = 0; i < num_pages && !entries_.empty(); i++)
         {
             VirtualPageNumber vpn = vpn_start + i;
+            publish(vpn, nullptr);
             entries_.erase(vpn);
         }
         LOG_DEBUG("Deallocated VPN range [%lu, %lu)", vpn_start, vpn_start + num_pages);
@@ -47,12 +78,18 @@ namespace uvm_sim
         if (entries_.find(vpn) == entries_.end())
         {
             entries_[vpn] = PageTableEntry();
+            publish(vpn, &entries_[vpn]);
         }
         return &entries_[vpn];
     }
 
     const PageTableEntry *PageTable::get_entry(VirtualPageNumber vpn) const
     {
+        if (auto entry = find_published(vpn))
+        {
+            return entry;
+        }
+
         std::shared_lock<std::shared_mutex> lock(mutex_);
         auto it = entries_.find(vpn);
         if (it != entries_.end())
@@ -64,13 +101,84 @@ namespace uvm_sim
 
     PageTableEntry *PageTable::lookup_entry(VirtualPageNumber vpn)
     {
-        std::shared_lock<std::shared_mutex> lock(mutex_);
-        auto it = entries_.find(vpn);
-        if (it != entries_.end())
+        if (auto entry = find_published(vpn))
         {
-            return &it->second;
+            return entry;
         }
-        return nullptr;
+
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = entries_.find(vpn);
+            if (it != entries_.end())
+            {
+                return &it->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (!is_reserved(vpn))
+        {
+            return nullptr;
+        }
+        auto inserted = entries_.try_emplace(vpn);
+        if (inserted.second)
+        {
+            inserted.first->second.is_valid = true;
+            inserted.first->second.is_zero = true;
+            publish(vpn, &inserted.first->second);
+        }
+        return &inserted.first->second;
+    }
+
+    PageTableEntry *PageTable::find_published(VirtualPageNumber vpn) const
+    {
+        size_t index = vpn / DIRECTORY_LEAF_PAGES;
+        if (index >= directory_size_)
+        {
+            return nullptr;
+        }
+        DirectoryLeaf *leaf = directory_[index].load(std::memory_order_acquire);
+        return leaf ? leaf->slots[vpn % DIRECTORY_LEAF_PAGES].load(std::memory_order_acquire) : nullptr;
+    }
+
+    void PageTable::publish(VirtualPageNumber vpn, PageTableEntry *entry)
+    {
+        // Caller holds mutex_ exclusively, which serializes leaf creation.
+        size_t index = vpn / DIRECTORY_LEAF_PAGES;
+        if (index >= directory_size_)
+        {
+            return;
+        }
+        DirectoryLeaf *leaf = directory_[index].load(std::memory_order_relaxed);
+        if (!leaf)
+        {
+            if (!entry)
+            {
+                return;
+            }
+            leaves_.push_back(std::make_unique<DirectoryLeaf>());
+            leaf = leaves_.back().get();
+            directory_[index].store(leaf, std::memory_order_release);
+        }
+        leaf->slots[vpn % DIRECTORY_LEAF_PAGES].store(entry, std::memory_order_release);
+    }
+
+    void PageTable::reset_directory()
+    {
+        // VPN 0 is reserved, so the last page sits at num_pages_.
+        directory_size_ = num_pages_ / DIRECTORY_LEAF_PAGES + 1;
+        directory_.reset(new std::atomic<DirectoryLeaf *>[directory_size_]);
+        for (size_t i = 0; i < directory_size_; i++)
+        {
+            directory_[i].store(nullptr, std::memory_order_relaxed);
+        }
+        leaves_.clear();
+    }
+
+    size_t PageTable::get_num_populated_pages() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return entries_.size();
     }
 
     void PageTable::set_cpu_resident(VirtualPageNumber vpn, void *cpu_addr)
@@ -97,13 +205,16 @@ namespace uvm_sim
         }
     }
 
-    void PageTable::mark_dirty(VirtualPageNumber vpn)
+    void PageTable::mark_dirty(VirtualPageNumber vpn, bool on_gpu)
     {
         std::unique_lock<std::shared_mutex> lock(mutex_);
         auto it = entries_.find(vpn);
         if (it != entries_.end())
         {
-            it->second.is_dirty = true;
+            if (on_gpu)
+                it->second.gpu_dirty = true;
+            else
+                it->second.cpu_dirty = true;
         }
     }
 
@@ -113,7 +224,10 @@ namespace uvm_sim
         auto it = entries_.find(vpn);
         if (it != entries_.end())
         {
-            it->second.is_dirty = false;
+            it->second.cpu_dirty = false;
+            it->second.gpu_dirty = false;
+            it->second.cpu_dirty_granules = 0;
+            it->second.gpu_dirty_granules = 0;
         }
     }
 
@@ -128,6 +242,32 @@ namespace uvm_sim
         }
     }
 
+    uint32_t PageTable::pin(VirtualPageNumber vpn)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = entries_.find(vpn);
+        if (it == entries_.end() || it->second.pin_count == UINT16_MAX)
+        {
+            return 0;
+        }
+        it->second.pin_count++;
+        it->second.is_pinned = true;
+        return it->second.pin_count;
+    }
+
+    uint32_t PageTable::unpin(VirtualPageNumber vpn)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = entries_.find(vpn);
+        if (it == entries_.end() || it->second.pin_count == 0)
+        {
+            return 0;
+        }
+        it->second.pin_count--;
+        it->second.is_pinned = it->second.pin_count > 0;
+        return it->second.pin_count;
+    }
+
     std::vector<std::pair<VirtualPageNumber, PageTableEntry *>> PageTable::get_all_entries()
     {
         std::shared_lock<std::shared_mutex> lock(mutex_);
@@ -146,6 +286,8 @@ namespace uvm_sim
     {
         std::unique_lock<std::shared_mutex> lock(mutex_);
         entries_.clear();
+        reserved_ranges_.clear();
+        reset_directory();
     }
 
 } 
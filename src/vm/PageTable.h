@@ -2,6 +2,7 @@
 
 #include "Common.h"
 #include <cstring>
+#include <map>
 
 namespace uvm_sim
 {
@@ -15,23 +16,41 @@ namespace uvm_sim
         
         bool resident_on_cpu : 1;
         bool resident_on_gpu : 1;
-        bool is_dirty : 1;
+        bool cpu_dirty : 1; // host copy written since the last H2D; the device copy is stale
+        bool gpu_dirty : 1; // device copy written since the last D2H; the host copy is stale
         bool is_pinned : 1; 
         bool is_valid : 1;
+        bool is_zero : 1; // never written on the host: no private CPU frame, reads see zeros
+        bool prefetched : 1; // moved to the GPU by a fault path prefetcher and not touched since
+        bool in_transit : 1; // a copy is running with the page lock dropped; wait for it before touching the page
+
+        // Usage hints set through VirtualMemoryManager::advise.
+        bool read_mostly : 1;     // keep duplicates on both sides; a write invalidates the other copy
+        bool preferred_cpu : 1;   // GPU demand faults map the host copy instead of migrating
+        bool preferred_gpu : 1;   // evicted only when no other page can be
+        bool accessed_by_gpu : 1; // GPU keeps a mapping; accesses to the host copy do not fault
 
         
         void *cpu_address;    
         uint64_t gpu_address; 
 
+        // Sub-page detail for cpu_dirty / gpu_dirty when VMConfig::dirty_granule_size
+        // is set; zero with the bit set means the whole page.
+        uint64_t cpu_dirty_granules;
+        uint64_t gpu_dirty_granules;
+
         
         uint64_t access_timestamp_us; 
         uint32_t access_count;        
         uint8_t clock_hand;           
+        uint16_t pin_count;           
 
         PageTableEntry()
-            : resident_on_cpu(false), resident_on_gpu(false), is_dirty(false),
-              is_pinned(false), is_valid(false), cpu_address(nullptr), gpu_address(0),
-              access_timestamp_us(0), access_count(0), clock_hand(0) {}
+            : resident_on_cpu(false), resident_on_gpu(false), cpu_dirty(false), gpu_dirty(false),
+              is_pinned(false), is_valid(false), is_zero(false), prefetched(false), in_transit(false), read_mostly(false),
+              preferred_cpu(false), preferred_gpu(false), accessed_by_gpu(false), cpu_address(nullptr), gpu_address(0),
+              cpu_dirty_granules(0), gpu_dirty_granules(0),
+              access_timestamp_us(0), access_count(0), clock_hand(0), pin_count(0) {}
     };
 
     
@@ -50,6 +69,10 @@ namespace uvm_sim
         
         bool allocate_vpn_range(VirtualPageNumber vpn_start, uint32_t num_pages);
 
+        // Reserves a range without creating entries. lookup_entry creates an
+        // unpopulated (is_zero) entry the first time a page in it is looked up.
+        bool reserve_vpn_range(VirtualPageNumber vpn_start, uint32_t num_pages);
+
         
         bool deallocate_vpn_range(VirtualPageNumber vpn_start, uint32_t num_pages);
 
@@ -69,7 +92,7 @@ namespace uvm_sim
         void set_gpu_resident(VirtualPageNumber vpn, uint64_t gpu_addr);
 
         
-        void mark_dirty(VirtualPageNumber vpn);
+        void mark_dirty(VirtualPageNumber vpn, bool on_gpu);
 
         
         void clear_dirty(VirtualPageNumber vpn);
@@ -78,8 +101,15 @@ namespace uvm_sim
         void update_access_time(VirtualPageNumber vpn);
 
         
+        uint32_t pin(VirtualPageNumber vpn);
+        uint32_t unpin(VirtualPageNumber vpn);
+
+        
         size_t get_num_allocated_pages() const { return num_pages_; }
 
+        // Entries actually created; reserved but untouched pages are not counted.
+        size_t get_num_populated_pages() const;
+
         
         size_t get_page_size() const { return page_size_; }
 
@@ -90,10 +120,33 @@ namespace uvm_sim
         void clear();
 
     private:
+        // Populated entries are also published in a two-level directory indexed
+        // by VPN, so lookups of existing pages read two atomics instead of taking
+        // mutex_. Leaves live until clear() or initialize(); entries stay in
+        // entries_, whose nodes do not move.
+        static constexpr size_t DIRECTORY_LEAF_PAGES = 512;
+
+        struct DirectoryLeaf
+        {
+            std::atomic<PageTableEntry *> slots[DIRECTORY_LEAF_PAGES] = {};
+        };
+
+        bool is_reserved(VirtualPageNumber vpn) const;
+
+        
+        PageTableEntry *find_published(VirtualPageNumber vpn) const;
+        void publish(VirtualPageNumber vpn, PageTableEntry *entry);
+        void reset_directory();
+
         size_t page_size_;
         size_t num_pages_;
         std::unordered_map<VirtualPageNumber, PageTableEntry> entries_;
+        std::map<VirtualPageNumber, uint32_t> reserved_ranges_;
         mutable std::shared_mutex mutex_;
+
+        std::unique_ptr<std::atomic<DirectoryLeaf *>[]> directory_;
+        size_t directory_size_ = 0;
+        std::vector<std::unique_ptr<DirectoryLeaf>> leaves_;
     };
 
 } 
@@ -3,6 +3,38 @@
 namespace uvm_sim
 {
 
+    VirtualPageNumber ReplacementPolicy::select_clean_victim(const std::function<bool(VirtualPageNumber)> &is_clean,
+                                                             size_t window)
+    {
+        std::vector<VirtualPageNumber> candidates;
+        VirtualPageNumber chosen = 0;
+        while (candidates.size() < std::max<size_t>(window, 1))
+        {
+            VirtualPageNumber vpn = select_victim();
+            if (vpn == 0)
+            {
+                break;
+            }
+            if (is_clean(vpn))
+            {
+                chosen = vpn;
+                break;
+            }
+            candidates.push_back(vpn);
+        }
+
+        if (chosen == 0 && !candidates.empty())
+        {
+            chosen = candidates.front();
+            candidates.erase(candidates.begin());
+        }
+        for (auto it = candidates.rbegin(); it != candidates.rend(); ++it)
+        {
+            on_victim_declined(*it);
+        }
+        return chosen;
+    }
+
     
     
     
@@ -12,57 +44,111 @@ namespace uvm_sim
     void LRUPolicy::on_page_access(VirtualPageNumber vpn)
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        
-        auto it = std::find(lru_queue_.begin(), lru_queue_.end(), vpn);
-        if (it != lru_queue_.end())
+        auto it = lru_index_.find(vpn);
+        if (it != lru_index_.end())
+        {
+            lru_list_.splice(lru_list_.end(), lru_list_, it->second);
+        }
+    }
+
+    void LRUPolicy::on_page_access_batch(const VirtualPageNumber *vpns, size_t count)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < count; i++)
         {
-            
-            
+            auto it = lru_index_.find(vpns[i]);
+            if (it != lru_index_.end())
+            {
+                lru_list_.splice(lru_list_.end(), lru_list_, it->second);
+            }
         }
     }
 
     void LRUPolicy::on_page_allocated(VirtualPageNumber vpn)
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        lru_queue_.push(vpn);
-        active_pages_.insert(vpn);
+        auto it = lru_index_.find(vpn);
+        if (it != lru_index_.end())
+        {
+            lru_list_.splice(lru_list_.end(), lru_list_, it->second);
+            return;
+        }
+
+        lru_index_[vpn] = lru_list_.insert(lru_list_.end(), vpn);
 
         
-        while (lru_queue_.size() > max_pages_)
+        while (lru_list_.size() > max_pages_)
         {
-            auto oldest = lru_queue_.front();
-            lru_queue_.pop();
-            active_pages_.erase(oldest);
+            lru_index_.erase(lru_list_.front());
+            lru_list_.pop_front();
         }
     }
 
     void LRUPolicy::on_page_freed(VirtualPageNumber vpn)
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        active_pages_.erase(vpn);
+        auto it = lru_index_.find(vpn);
+        if (it != lru_index_.end())
+        {
+            lru_list_.erase(it->second);
+            lru_index_.erase(it);
+        }
     }
 
     VirtualPageNumber LRUPolicy::select_victim()
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        if (lru_queue_.empty())
+        if (lru_list_.empty())
         {
             return 0;
         }
-        VirtualPageNumber victim = lru_queue_.front();
-        lru_queue_.pop();
-        active_pages_.erase(victim);
+        VirtualPageNumber victim = lru_list_.front();
+        lru_list_.pop_front();
+        lru_index_.erase(victim);
         return victim;
     }
 
-    void LRUPolicy::reset()
+    VirtualPageNumber LRUPolicy::select_clean_victim(const std::function<bool(VirtualPageNumber)> &is_clean,
+                                                     size_t window)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (lru_list_.empty())
+        {
+            return 0;
+        }
+
+        // Scan from the cold end without disturbing the recency order of skipped pages.
+        auto victim_it = lru_list_.begin();
+        size_t scanned = 0;
+        for (auto it = lru_list_.begin(); it != lru_list_.end() && scanned < window; ++it, ++scanned)
+        {
+            if (is_clean(*it))
+            {
+                victim_it = it;
+                break;
+            }
+        }
+
+        VirtualPageNumber victim = *victim_it;
+        lru_index_.erase(victim);
+        lru_list_.erase(victim_it);
+        return victim;
+    }
+
+    void LRUPolicy::on_victim_declined(VirtualPageNumber vpn)
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        while (!lru_queue_.empty())
+        if (lru_index_.count(vpn) == 0)
         {
-            lru_queue_.pop();
+            lru_index_[vpn] = lru_list_.insert(lru_list_.begin(), vpn);
         }
-        active_pages_.clear();
+    }
+
+    void LRUPolicy::reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lru_list_.clear();
+        lru_index_.clear();
     }
 
     
@@ -74,13 +160,22 @@ namespace uvm_sim
     void CLOCKPolicy::on_page_access(VirtualPageNumber vpn)
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        
-        for (auto &entry : clock_hand_vec_)
+        auto it = slot_index_.find(vpn);
+        if (it != slot_index_.end())
+        {
+            clock_hand_vec_[it->second].reference_bit = true;
+        }
+    }
+
+    void CLOCKPolicy::on_page_access_batch(const VirtualPageNumber *vpns, size_t count)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < count; i++)
         {
-            if (entry.vpn == vpn)
+            auto it = slot_index_.find(vpns[i]);
+            if (it != slot_index_.end())
             {
-                entry.reference_bit = true;
-                return;
+                clock_hand_vec_[it->second].reference_bit = true;
             }
         }
     }
@@ -88,81 +183,218 @@ namespace uvm_sim
     void CLOCKPolicy::on_page_allocated(VirtualPageNumber vpn)
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        clock_hand_vec_.emplace_back(vpn);
+        auto it = slot_index_.find(vpn);
+        if (it != slot_index_.end())
+        {
+            clock_hand_vec_[it->second].reference_bit = true;
+            return;
+        }
 
         
-        while (clock_hand_vec_.size() > max_pages_)
+        while (slot_index_.size() >= max_pages_ && !slot_index_.empty())
         {
-            if (hand_pos_ >= clock_hand_vec_.size())
-            {
-                hand_pos_ = 0;
-            }
-            clock_hand_vec_.erase(clock_hand_vec_.begin() + hand_pos_);
-            if (hand_pos_ >= clock_hand_vec_.size() && !clock_hand_vec_.empty())
-            {
-                hand_pos_ = 0;
-            }
+            sweep();
         }
+
+        size_t slot;
+        if (!free_slots_.empty())
+        {
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+            clock_hand_vec_[slot] = ClockEntry(vpn);
+        }
+        else
+        {
+            slot = clock_hand_vec_.size();
+            clock_hand_vec_.emplace_back(vpn);
+        }
+        slot_index_[vpn] = slot;
     }
 
     void CLOCKPolicy::on_page_freed(VirtualPageNumber vpn)
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        for (size_t i = 0; i < clock_hand_vec_.size(); i++)
+        auto it = slot_index_.find(vpn);
+        if (it != slot_index_.end())
         {
-            if (clock_hand_vec_[i].vpn == vpn)
-            {
-                clock_hand_vec_.erase(clock_hand_vec_.begin() + i);
-                if (hand_pos_ >= clock_hand_vec_.size() && !clock_hand_vec_.empty())
-                {
-                    hand_pos_ = 0;
-                }
-                return;
-            }
+            size_t slot = it->second;
+            slot_index_.erase(it);
+            release_slot(slot);
         }
     }
 
     VirtualPageNumber CLOCKPolicy::select_victim()
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        if (clock_hand_vec_.empty())
+        if (slot_index_.empty())
         {
             return 0;
         }
+        return sweep();
+    }
 
+    VirtualPageNumber CLOCKPolicy::sweep()
+    {
         
-        while (hand_pos_ < clock_hand_vec_.size())
+        while (true)
         {
-            if (!clock_hand_vec_[hand_pos_].reference_bit)
+            if (hand_pos_ >= clock_hand_vec_.size())
+            {
+                hand_pos_ = 0;
+            }
+
+            ClockEntry &entry = clock_hand_vec_[hand_pos_];
+            size_t slot = hand_pos_;
+            hand_pos_++;
+
+            if (!entry.in_use)
+            {
+                continue;
+            }
+            if (entry.reference_bit)
             {
-                VirtualPageNumber victim = clock_hand_vec_[hand_pos_].vpn;
-                hand_pos_ = (hand_pos_ + 1) % clock_hand_vec_.size();
-                clock_hand_vec_.erase(clock_hand_vec_.begin() + hand_pos_);
-                return victim;
+                entry.reference_bit = false;
+                continue;
             }
 
-            
-            clock_hand_vec_[hand_pos_].reference_bit = false;
-            hand_pos_ = (hand_pos_ + 1) % clock_hand_vec_.size();
+            VirtualPageNumber victim = entry.vpn;
+            slot_index_.erase(victim);
+            release_slot(slot);
+            return victim;
         }
+    }
 
-        
-        if (!clock_hand_vec_.empty())
+    void CLOCKPolicy::on_victim_declined(VirtualPageNumber vpn)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (slot_index_.count(vpn))
         {
-            VirtualPageNumber victim = clock_hand_vec_[hand_pos_].vpn;
-            hand_pos_ = (hand_pos_ + 1) % clock_hand_vec_.size();
-            clock_hand_vec_.erase(clock_hand_vec_.begin() + hand_pos_);
-            return victim;
+            return;
+        }
+
+        // The victim's slot is the last one released; put it back under the hand
+        // with its reference bit clear, without sweeping for room.
+        size_t slot;
+        if (!free_slots_.empty())
+        {
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+            clock_hand_vec_[slot] = ClockEntry(vpn);
         }
+        else
+        {
+            slot = clock_hand_vec_.size();
+            clock_hand_vec_.emplace_back(vpn);
+        }
+        clock_hand_vec_[slot].reference_bit = false;
+        slot_index_[vpn] = slot;
+        hand_pos_ = slot;
+    }
 
-        return 0;
+    void CLOCKPolicy::release_slot(size_t slot)
+    {
+        clock_hand_vec_[slot].in_use = false;
+        free_slots_.push_back(slot);
     }
 
     void CLOCKPolicy::reset()
     {
         std::lock_guard<std::mutex> lock(mutex_);
         clock_hand_vec_.clear();
+        slot_index_.clear();
+        free_slots_.clear();
         hand_pos_ = 0;
     }
 
+    
+    
+    
+
+    BeladyPolicy::BeladyPolicy(const std::vector<VirtualPageNumber> &trace)
+        : trace_(trace), next_use_(trace.size(), NEVER), cursor_(0)
+    {
+        std::unordered_map<VirtualPageNumber, size_t> last_seen;
+        last_seen.reserve(trace_.size() / 4 + 16);
+        for (size_t i = trace_.size(); i-- > 0;)
+        {
+            auto it = last_seen.find(trace_[i]);
+            if (it != last_seen.end())
+            {
+                next_use_[i] = it->second;
+                it->second = i;
+            }
+            else
+            {
+                last_seen.emplace(trace_[i], i);
+            }
+        }
+    }
+
+    void BeladyPolicy::advance(VirtualPageNumber vpn)
+    {
+        if (cursor_ >= trace_.size() || trace_[cursor_] != vpn)
+        {
+            LOG_WARN("BeladyPolicy: access to VPN %lu does not match trace position %zu", vpn, cursor_);
+            return;
+        }
+
+        size_t next = next_use_[cursor_++];
+        auto it = resident_next_use_.find(vpn);
+        if (it != resident_next_use_.end())
+        {
+            by_next_use_.erase({it->second, vpn});
+            it->second = next;
+        }
+        else
+        {
+            resident_next_use_.emplace(vpn, next);
+        }
+        by_next_use_.insert({next, vpn});
+    }
+
+    void BeladyPolicy::on_page_access(VirtualPageNumber vpn)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        advance(vpn);
+    }
+
+    void BeladyPolicy::on_page_allocated(VirtualPageNumber vpn)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        advance(vpn);
+    }
+
+    void BeladyPolicy::on_page_freed(VirtualPageNumber vpn)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = resident_next_use_.find(vpn);
+        if (it != resident_next_use_.end())
+        {
+            by_next_use_.erase({it->second, vpn});
+            resident_next_use_.erase(it);
+        }
+    }
+
+    VirtualPageNumber BeladyPolicy::select_victim()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (by_next_use_.empty())
+        {
+            return 0;
+        }
+        auto farthest = std::prev(by_next_use_.end());
+        VirtualPageNumber victim = farthest->second;
+        by_next_use_.erase(farthest);
+        resident_next_use_.erase(victim);
+        return victim;
+    }
+
+    void BeladyPolicy::reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        by_next_use_.clear();
+        resident_next_use_.clear();
+        cursor_ = 0;
+    }
+
 } 
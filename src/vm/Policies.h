@@ -2,6 +2,9 @@
 
 #include "Common.h"
 #include "PageTable.h"
+#include <functional>
+#include <list>
+#include <set>
 
 namespace uvm_sim
 {
@@ -16,10 +19,32 @@ namespace uvm_sim
         virtual ~ReplacementPolicy() = default;
 
         virtual void on_page_access(VirtualPageNumber vpn) = 0;
+        virtual void on_page_access_batch(const VirtualPageNumber *vpns, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                on_page_access(vpns[i]);
+            }
+        }
         virtual void on_page_allocated(VirtualPageNumber vpn) = 0;
         virtual void on_page_freed(VirtualPageNumber vpn) = 0;
         virtual VirtualPageNumber select_victim() = 0;
         virtual void reset() = 0;
+
+        // Pinned pages leave the candidate set entirely so victim selection never has to skip them.
+        virtual void on_page_pinned(VirtualPageNumber vpn) { on_page_freed(vpn); }
+        virtual void on_page_unpinned(VirtualPageNumber vpn) { on_page_allocated(vpn); }
+
+        // Hands back a page select_victim returned but the caller kept resident,
+        // as the next candidate again rather than as a fresh allocation.
+        virtual void on_victim_declined(VirtualPageNumber vpn) { on_page_allocated(vpn); }
+
+        // Cost-aware selection: the first of the next `window` victims that
+        // is_clean accepts (no writeback needed), else the first candidate.
+        // The default pops candidates and hands the passed-over ones back
+        // through on_victim_declined.
+        virtual VirtualPageNumber select_clean_victim(const std::function<bool(VirtualPageNumber)> &is_clean,
+                                                      size_t window);
     };
 
     
@@ -32,14 +57,18 @@ namespace uvm_sim
         explicit LRUPolicy(size_t max_pages = 10000);
 
         void on_page_access(VirtualPageNumber vpn) override;
+        void on_page_access_batch(const VirtualPageNumber *vpns, size_t count) override;
         void on_page_allocated(VirtualPageNumber vpn) override;
         void on_page_freed(VirtualPageNumber vpn) override;
         VirtualPageNumber select_victim() override;
+        VirtualPageNumber select_clean_victim(const std::function<bool(VirtualPageNumber)> &is_clean,
+                                              size_t window) override;
+        void on_victim_declined(VirtualPageNumber vpn) override;
         void reset() override;
 
     private:
-        std::queue<VirtualPageNumber> lru_queue_;
-        std::unordered_set<VirtualPageNumber> active_pages_;
+        std::list<VirtualPageNumber> lru_list_;
+        std::unordered_map<VirtualPageNumber, std::list<VirtualPageNumber>::iterator> lru_index_;
         size_t max_pages_;
         mutable std::mutex mutex_;
     };
@@ -54,9 +83,11 @@ namespace uvm_sim
         explicit CLOCKPolicy(size_t max_pages = 10000);
 
         void on_page_access(VirtualPageNumber vpn) override;
+        void on_page_access_batch(const VirtualPageNumber *vpns, size_t count) override;
         void on_page_allocated(VirtualPageNumber vpn) override;
         void on_page_freed(VirtualPageNumber vpn) override;
         VirtualPageNumber select_victim() override;
+        void on_victim_declined(VirtualPageNumber vpn) override;
         void reset() override;
 
     private:
@@ -64,14 +95,54 @@ namespace uvm_sim
         {
             VirtualPageNumber vpn;
             bool reference_bit;
+            bool in_use;
 
-            ClockEntry(VirtualPageNumber v) : vpn(v), reference_bit(true) {}
+            ClockEntry(VirtualPageNumber v) : vpn(v), reference_bit(true), in_use(true) {}
         };
 
         std::vector<ClockEntry> clock_hand_vec_;
+        std::unordered_map<VirtualPageNumber, size_t> slot_index_;
+        std::vector<size_t> free_slots_;
         size_t hand_pos_;
         size_t max_pages_;
         mutable std::mutex mutex_;
+
+        VirtualPageNumber sweep();
+        void release_slot(size_t slot);
+    };
+
+    
+    
+    
+
+    // Offline optimal (MIN) policy for trace replay: evicts the resident page
+    // whose next reference is farthest away. Every access in the trace must
+    // be reported in order, hits via on_page_access and misses via
+    // on_page_allocated.
+    class BeladyPolicy : public ReplacementPolicy
+    {
+    public:
+        explicit BeladyPolicy(const std::vector<VirtualPageNumber> &trace);
+
+        void on_page_access(VirtualPageNumber vpn) override;
+        void on_page_allocated(VirtualPageNumber vpn) override;
+        void on_page_freed(VirtualPageNumber vpn) override;
+        VirtualPageNumber select_victim() override;
+        void reset() override;
+
+        size_t get_position() const { return cursor_; }
+
+    private:
+        static constexpr size_t NEVER = SIZE_MAX;
+
+        std::vector<VirtualPageNumber> trace_;
+        std::vector<size_t> next_use_;
+        size_t cursor_;
+        std::set<std::pair<size_t, VirtualPageNumber>> by_next_use_;
+        std::unordered_map<VirtualPageNumber, size_t> resident_next_use_;
+        mutable std::mutex mutex_;
+
+        void advance(VirtualPageNumber vpn);
     };
 
 } 
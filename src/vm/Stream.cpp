@@ -0,0 +1,77 @@
+#include "Stream.h"
+
+namespace uvm_sim
+{
+
+    Stream::Stream() : shutdown_(false), running_(false)
+    {
+        worker_ = std::thread(&Stream::worker_thread, this);
+    }
+
+    Stream::~Stream()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            shutdown_ = true;
+        }
+        cv_.notify_all();
+        if (worker_.joinable())
+        {
+            worker_.join();
+        }
+    }
+
+    void Stream::enqueue(std::function<void()> work)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            work_.push_back(std::move(work));
+        }
+        cv_.notify_one();
+    }
+
+    Event Stream::record()
+    {
+        auto done = std::make_shared<std::promise<void>>();
+        Event event(done->get_future().share());
+        enqueue([done]()
+                { done->set_value(); });
+        return event;
+    }
+
+    bool Stream::query()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return work_.empty() && !running_;
+    }
+
+    void Stream::synchronize()
+    {
+        record().synchronize();
+    }
+
+    void Stream::worker_thread()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            cv_.wait(lock, [this]()
+                     { return shutdown_ || !work_.empty(); });
+            // Drain queued work before exiting so recorded events still complete.
+            if (work_.empty())
+            {
+                break;
+            }
+
+            auto work = std::move(work_.front());
+            work_.pop_front();
+            running_ = true;
+            lock.unlock();
+            work();
+            completed_++;
+            lock.lock();
+            running_ = false;
+        }
+    }
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Common.h"
+#include <functional>
+#include <future>
+
+namespace uvm_sim
+{
+
+    // Marks a point in a stream's work; complete once everything enqueued on
+    // the stream before it has finished.
+    class Event
+    {
+    public:
+        Event() = default;
+        explicit Event(std::shared_future<void> done) : done_(std::move(done)) {}
+
+        
+        bool query() const
+        {
+            return !done_.valid() || done_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+
+        
+        void synchronize() const
+        {
+            if (done_.valid())
+            {
+                done_.wait();
+            }
+        }
+
+    private:
+        std::shared_future<void> done_;
+    };
+
+    
+    
+    
+
+    // In-order queue of asynchronous VM work in the spirit of a CUDA stream.
+    // Operations on one stream run one after another on the stream's worker
+    // thread; separate streams run concurrently.
+    class Stream
+    {
+    public:
+        Stream();
+        ~Stream();
+
+        Stream(const Stream &) = delete;
+        Stream &operator=(const Stream &) = delete;
+
+        
+        void enqueue(std::function<void()> work);
+
+        
+        Event record();
+
+        
+        bool query();
+        void synchronize();
+
+        uint64_t get_completed() const { return completed_.load(std::memory_order_relaxed); }
+
+    private:
+        void worker_thread();
+
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::deque<std::function<void()>> work_;
+        bool shutdown_;
+        bool running_;
+        std::thread worker_;
+
+        std::atomic<uint64_t> completed_{0};
+    };
+
+}
@@ -0,0 +1,194 @@
+#include "StridePrefetcher.h"
+
+namespace uvm_sim
+{
+
+    StridePrefetcher::StridePrefetcher(const Config &config)
+        : config_(config), clock_(0), window_useful_(0), window_wasted_(0)
+    {
+        if (config_.streams == 0)
+        {
+            config_.streams = 1;
+        }
+        if (config_.confirmations == 0)
+        {
+            config_.confirmations = 1;
+        }
+        config_.min_depth = std::max<size_t>(config_.min_depth, 1);
+        config_.max_depth = std::max(config_.max_depth, config_.min_depth);
+        streams_.resize(config_.streams);
+        depth_cap_ = config_.max_depth;
+    }
+
+    StridePrefetcher::Prefetch StridePrefetcher::on_access(VirtualPageNumber vpn)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        Prefetch prefetch;
+        StreamState &stream = find_stream(vpn);
+        stream.last_use = ++clock_;
+
+        if (stream.last_vpn == 0)
+        {
+            stream.last_vpn = vpn;
+            return prefetch;
+        }
+
+        int64_t delta = (int64_t)(vpn - stream.last_vpn);
+        if (delta == 0)
+        {
+            return prefetch;
+        }
+        stream.last_vpn = vpn;
+
+        if (delta != stream.stride)
+        {
+            stream.stride = delta;
+            stream.confirmations = 1;
+            stream.depth = 0;
+            stream.next_vpn = 0;
+        }
+        else if (stream.confirmations < config_.confirmations)
+        {
+            stream.confirmations++;
+        }
+
+        if (stream.confirmations < config_.confirmations)
+        {
+            return prefetch;
+        }
+
+        // Steps along the stride already covered by the prefetched window.
+        int64_t covered = stream.next_vpn ? (int64_t)(stream.next_vpn - vpn) / stream.stride - 1 : 0;
+        covered = std::max<int64_t>(covered, 0);
+        if (stream.depth && (size_t)covered * 2 > stream.depth)
+        {
+            return prefetch;
+        }
+
+        stream.depth = stream.depth ? std::min(stream.depth * 2, depth_cap_) : std::min(config_.min_depth, depth_cap_);
+        size_t depth = stream.depth;
+        if (stream.stride < 0)
+        {
+            // Stop before VPN 0.
+            depth = std::min<size_t>(depth, (vpn - 1) / (VirtualPageNumber)(-stream.stride));
+        }
+        if (depth <= (size_t)covered)
+        {
+            return prefetch;
+        }
+
+        prefetch.start = vpn + (covered + 1) * stream.stride;
+        prefetch.stride = stream.stride;
+        prefetch.count = depth - covered;
+        stream.next_vpn = vpn + (int64_t)(depth + 1) * stream.stride;
+        issued_ += prefetch.count;
+        return prefetch;
+    }
+
+    StridePrefetcher::StreamState &StridePrefetcher::find_stream(VirtualPageNumber vpn)
+    {
+        StreamState *nearest = nullptr;
+        StreamState *oldest = &streams_[0];
+        int64_t nearest_distance = config_.max_stride + 1;
+
+        for (auto &stream : streams_)
+        {
+            if (stream.last_use < oldest->last_use)
+            {
+                oldest = &stream;
+            }
+            if (stream.last_vpn == 0)
+            {
+                continue;
+            }
+
+            // A touch inside a stream's prefetched window belongs to that stream.
+            int64_t distance = std::abs((int64_t)(vpn - stream.last_vpn));
+            if (stream.next_vpn && stream.stride)
+            {
+                int64_t steps = (int64_t)(vpn - stream.last_vpn) / stream.stride;
+                int64_t window = (int64_t)(stream.next_vpn - stream.last_vpn) / stream.stride;
+                if (steps > 0 && steps <= window)
+                {
+                    distance = 0;
+                }
+            }
+            if (distance < nearest_distance)
+            {
+                nearest = &stream;
+                nearest_distance = distance;
+            }
+        }
+
+        if (nearest)
+        {
+            return *nearest;
+        }
+        *oldest = StreamState();
+        return *oldest;
+    }
+
+    void StridePrefetcher::on_useful()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        useful_++;
+        window_useful_++;
+        adjust_depth_cap();
+    }
+
+    void StridePrefetcher::on_wasted()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wasted_++;
+        window_wasted_++;
+        adjust_depth_cap();
+    }
+
+    void StridePrefetcher::adjust_depth_cap()
+    {
+        uint64_t judged = window_useful_ + window_wasted_;
+        if (judged < config_.accuracy_window)
+        {
+            return;
+        }
+
+        if ((double)window_useful_ / judged < config_.min_accuracy)
+        {
+            depth_cap_ = std::max(depth_cap_ / 2, config_.min_depth);
+        }
+        else
+        {
+            depth_cap_ = std::min(depth_cap_ * 2, config_.max_depth);
+        }
+        window_useful_ = 0;
+        window_wasted_ = 0;
+    }
+
+    void StridePrefetcher::reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::fill(streams_.begin(), streams_.end(), StreamState());
+        clock_ = 0;
+        depth_cap_ = config_.max_depth;
+        window_useful_ = 0;
+        window_wasted_ = 0;
+        issued_ = 0;
+        useful_ = 0;
+        wasted_ = 0;
+    }
+
+    double StridePrefetcher::get_accuracy() const
+    {
+        uint64_t useful = get_useful();
+        uint64_t judged = useful + get_wasted();
+        return judged ? (double)useful / judged : 0.0;
+    }
+
+    size_t StridePrefetcher::get_depth_cap() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return depth_cap_;
+    }
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Common.h"
+
+namespace uvm_sim
+{
+
+    // Detects sequential and strided GPU fault streams and proposes the next
+    // pages to migrate ahead of them. Streams are told apart by address
+    // proximity, so walks over different allocations (or by different threads)
+    // train separate entries. A stream prefetches once the same stride is seen
+    // `confirmations` times in a row, and its window is topped up as touches of
+    // prefetched pages use up half of it. The depth doubles with every top-up
+    // up to a shared cap, which halves while too few prefetched pages are used
+    // before eviction and grows back as accuracy recovers.
+    class StridePrefetcher
+    {
+    public:
+        struct Config
+        {
+            size_t streams = 16;          // fault streams tracked at once
+            int64_t max_stride = 16;      // larger jumps start a new stream
+            uint32_t confirmations = 2;   // times a stride is seen before prefetching
+            size_t min_depth = 2;         // pages ahead of a freshly confirmed stream
+            size_t max_depth = 64;
+            double min_accuracy = 0.5;    // useful fraction below which the depth cap halves
+            size_t accuracy_window = 64;  // prefetches judged per depth cap adjustment
+        };
+
+        // Pages start, start + stride, ... (count of them) to migrate; count 0 is none.
+        struct Prefetch
+        {
+            VirtualPageNumber start = 0;
+            int64_t stride = 0;
+            size_t count = 0;
+        };
+
+        explicit StridePrefetcher(const Config &config = Config());
+
+        
+        // Called for demand faults and for first touches of prefetched pages.
+        Prefetch on_access(VirtualPageNumber vpn);
+
+        
+        void on_useful();
+        void on_wasted();
+
+        void reset();
+
+        uint64_t get_issued() const { return issued_.load(std::memory_order_relaxed); }
+        uint64_t get_useful() const { return useful_.load(std::memory_order_relaxed); }
+        uint64_t get_wasted() const { return wasted_.load(std::memory_order_relaxed); }
+        double get_accuracy() const;
+        size_t get_depth_cap() const;
+        const Config &get_config() const { return config_; }
+
+    private:
+        struct StreamState
+        {
+            VirtualPageNumber last_vpn = 0;
+            VirtualPageNumber next_vpn = 0; // first page past the prefetched window
+            int64_t stride = 0;
+            uint32_t confirmations = 0;
+            size_t depth = 0;
+            uint64_t last_use = 0;
+        };
+
+        StreamState &find_stream(VirtualPageNumber vpn);
+        void adjust_depth_cap();
+
+        Config config_;
+        std::vector<StreamState> streams_;
+        uint64_t clock_;
+        size_t depth_cap_;
+        uint64_t window_useful_;
+        uint64_t window_wasted_;
+        mutable std::mutex mutex_;
+
+        std::atomic<uint64_t> issued_{0};
+        std::atomic<uint64_t> useful_{0};
+        std::atomic<uint64_t> wasted_{0};
+    };
+
+}
@@ -0,0 +1,141 @@
+#include "ThrashDetector.h"
+
+namespace uvm_sim
+{
+
+    ThrashDetector::ThrashDetector(const Config &config) : config_(config), thrash_events_(0)
+    {
+        if (config_.region_pages == 0)
+        {
+            config_.region_pages = 1;
+        }
+        if (config_.threshold == 0)
+        {
+            config_.threshold = 1;
+        }
+    }
+
+    void ThrashDetector::on_eviction(VirtualPageNumber vpn, uint64_t now_us)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        RegionState &state = regions_[region_of(vpn)];
+        state.last_eviction_us = now_us;
+
+        if (state.tracked.empty())
+        {
+            state.tracked.resize((config_.region_pages + 63) / 64, 0);
+        }
+        size_t offset = vpn % config_.region_pages;
+        uint64_t bit = 1ULL << (offset % 64);
+        if (!(state.tracked[offset / 64] & bit))
+        {
+            state.tracked[offset / 64] |= bit;
+            state.tracked_pages++;
+        }
+    }
+
+    ThrashMitigation ThrashDetector::on_fault(VirtualPageNumber vpn, uint64_t now_us)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = regions_.find(region_of(vpn));
+        if (it == regions_.end() || it->second.last_eviction_us == 0)
+        {
+            return ThrashMitigation::NONE;
+        }
+
+        RegionState &state = it->second;
+        uint64_t evicted_us = state.last_eviction_us;
+        state.last_eviction_us = 0;
+
+        
+        if (now_us - evicted_us > config_.window_us)
+        {
+            state.bounces = 0;
+            return ThrashMitigation::NONE;
+        }
+
+        if (state.bounces == 0 || now_us - state.window_start_us > config_.window_us)
+        {
+            state.window_start_us = now_us;
+            state.bounces = 0;
+        }
+        state.bounces++;
+
+        if (state.bounces < config_.threshold)
+        {
+            return ThrashMitigation::NONE;
+        }
+
+        state.bounces = 0;
+        thrash_events_++;
+
+        switch (config_.mitigation)
+        {
+        case ThrashMitigation::PIN:
+            state.pinned_until_us = now_us + config_.pin_duration_us;
+            break;
+        case ThrashMitigation::REMOTE:
+            state.remote_until_us = now_us + config_.remote_duration_us;
+            break;
+        default:
+            break;
+        }
+
+        LOG_DEBUG("Thrashing detected on VPN %lu (region %lu)", vpn, region_of(vpn));
+        return config_.mitigation;
+    }
+
+    bool ThrashDetector::is_pinned(VirtualPageNumber vpn, uint64_t now_us) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = regions_.find(region_of(vpn));
+        return it != regions_.end() && it->second.pinned_until_us > now_us;
+    }
+
+    bool ThrashDetector::is_remote(VirtualPageNumber vpn, uint64_t now_us) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = regions_.find(region_of(vpn));
+        return it != regions_.end() && it->second.remote_until_us > now_us;
+    }
+
+    void ThrashDetector::on_page_freed(VirtualPageNumber vpn)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = regions_.find(region_of(vpn));
+        if (it == regions_.end())
+        {
+            return;
+        }
+
+        RegionState &state = it->second;
+        size_t offset = vpn % config_.region_pages;
+        uint64_t bit = 1ULL << (offset % 64);
+        if (state.tracked[offset / 64] & bit)
+        {
+            state.tracked[offset / 64] &= ~bit;
+            state.tracked_pages--;
+        }
+
+        // Drop the region once none of its evicted pages are still allocated.
+        if (state.tracked_pages == 0)
+        {
+            regions_.erase(it);
+        }
+    }
+
+    size_t ThrashDetector::get_tracked_regions() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return regions_.size();
+    }
+
+    void ThrashDetector::reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        regions_.clear();
+        thrash_events_ = 0;
+    }
+
+}
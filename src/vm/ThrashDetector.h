@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Common.h"
+
+namespace uvm_sim
+{
+
+    enum class ThrashMitigation : uint8_t
+    {
+        NONE = 0,
+        PIN = 1,      // keep the page on the GPU for pin_duration_us
+        THROTTLE = 2, // delay the faulting thread by throttle_us
+        REMOTE = 3    // leave the page on the CPU and access it over the link
+    };
+
+    // Tracks eviction -> refault intervals per region. A region that is
+    // refaulted `threshold` times within `window_us` of being evicted is
+    // considered thrashing and the configured mitigation is applied.
+    class ThrashDetector
+    {
+    public:
+        struct Config
+        {
+            uint32_t threshold = 3;      // refaults within the window before mitigating
+            uint64_t window_us = 100000;
+            uint32_t region_pages = 1;   // pages tracked together
+            ThrashMitigation mitigation = ThrashMitigation::PIN;
+            uint64_t pin_duration_us = 50000;
+            uint64_t throttle_us = 100;
+            uint64_t remote_duration_us = 50000;
+        };
+
+        explicit ThrashDetector(const Config &config = Config());
+
+        
+        void on_eviction(VirtualPageNumber vpn, uint64_t now_us);
+
+        
+        ThrashMitigation on_fault(VirtualPageNumber vpn, uint64_t now_us);
+
+        
+        bool is_pinned(VirtualPageNumber vpn, uint64_t now_us) const;
+
+        
+        bool is_remote(VirtualPageNumber vpn, uint64_t now_us) const;
+
+        void on_page_freed(VirtualPageNumber vpn);
+        void reset();
+
+        uint64_t get_thrash_events() const { return thrash_events_.load(std::memory_order_relaxed); }
+        size_t get_tracked_regions() const;
+        const Config &get_config() const { return config_; }
+
+    private:
+        struct RegionState
+        {
+            uint64_t last_eviction_us = 0;
+            uint64_t window_start_us = 0;
+            uint32_t bounces = 0;
+            uint64_t pinned_until_us = 0;
+            uint64_t remote_until_us = 0;
+            std::vector<uint64_t> tracked; // bitmap of pages evicted and not yet freed
+            size_t tracked_pages = 0;
+        };
+
+        uint64_t region_of(VirtualPageNumber vpn) const { return vpn / config_.region_pages; }
+
+        Config config_;
+        std::unordered_map<uint64_t, RegionState> regions_;
+        std::atomic<uint64_t> thrash_events_;
+        mutable std::mutex mutex_;
+    };
+
+}
@@ -0,0 +1,176 @@
+#include "TraceSimulator.h"
+#include <fstream>
+#include <sstream>
+
+namespace uvm_sim
+{
+
+    TraceSimulator::TraceSimulator(const Config &config) : config_(config)
+    {
+        if (config_.trace_page_size == 0 || config_.page_size % config_.trace_page_size != 0)
+        {
+            LOG_WARN("TraceSimulator: page size %zu is not a multiple of trace page size %zu, replaying unscaled",
+                     config_.page_size, config_.trace_page_size);
+            config_.trace_page_size = config_.page_size;
+        }
+        if (config_.gpu_frames == 0)
+        {
+            LOG_ERROR("TraceSimulator: gpu_frames must be at least 1, traces will not be replayed");
+        }
+    }
+
+    std::vector<TraceAccess> TraceSimulator::rescale(const std::vector<TraceAccess> &trace) const
+    {
+        size_t ratio = config_.page_size / config_.trace_page_size;
+        std::vector<TraceAccess> scaled;
+        scaled.reserve(trace.size());
+        for (const auto &access : trace)
+        {
+            // Offset by one: policies return VPN 0 as "no victim".
+            scaled.push_back({access.vpn / ratio + 1, access.is_write});
+        }
+        return scaled;
+    }
+
+    TraceSimulator::Result TraceSimulator::run(const std::vector<TraceAccess> &trace, ReplacementPolicy &policy,
+                                               const std::string &name) const
+    {
+        if (config_.page_size == config_.trace_page_size)
+        {
+            return replay(trace, policy, name);
+        }
+        return replay(rescale(trace), policy, name);
+    }
+
+    TraceSimulator::Result TraceSimulator::run_optimal(const std::vector<TraceAccess> &trace) const
+    {
+        std::vector<TraceAccess> scaled = config_.page_size == config_.trace_page_size ? trace : rescale(trace);
+
+        std::vector<VirtualPageNumber> vpns;
+        vpns.reserve(scaled.size());
+        for (const auto &access : scaled)
+        {
+            vpns.push_back(access.vpn);
+        }
+
+        BeladyPolicy optimal(vpns);
+        return replay(scaled, optimal, "OPT");
+    }
+
+    TraceSimulator::Result TraceSimulator::replay(const std::vector<TraceAccess> &trace, ReplacementPolicy &policy,
+                                                  const std::string &name) const
+    {
+        Result result;
+        result.policy = name;
+        result.gpu_frames = config_.gpu_frames;
+        result.page_size = config_.page_size;
+
+        if (config_.gpu_frames == 0)
+        {
+            return result;
+        }
+
+        policy.reset();
+
+        
+        std::unordered_map<VirtualPageNumber, bool> resident;
+        resident.reserve(config_.gpu_frames * 2);
+
+        uint64_t start_us = get_timestamp_us();
+
+        for (const auto &access : trace)
+        {
+            result.accesses++;
+
+            auto it = resident.find(access.vpn);
+            if (it != resident.end())
+            {
+                result.hits++;
+                it->second = it->second || access.is_write;
+                policy.on_page_access(access.vpn);
+                continue;
+            }
+
+            result.misses++;
+            result.migrated_bytes += config_.page_size;
+
+            if (resident.size() >= config_.gpu_frames)
+            {
+                VirtualPageNumber victim = policy.select_victim();
+                auto victim_it = resident.find(victim);
+                if (victim_it == resident.end())
+                {
+                    
+                    victim_it = resident.begin();
+                    policy.on_page_freed(victim_it->first);
+                }
+
+                if (victim_it->second)
+                {
+                    result.writebacks++;
+                    result.migrated_bytes += config_.page_size;
+                }
+                resident.erase(victim_it);
+                result.evictions++;
+            }
+
+            resident.emplace(access.vpn, access.is_write);
+            policy.on_page_allocated(access.vpn);
+        }
+
+        result.elapsed_us = get_timestamp_us() - start_us;
+        return result;
+    }
+
+    std::vector<TraceAccess> TraceSimulator::load_trace(const std::string &path)
+    {
+        std::vector<TraceAccess> trace;
+        std::ifstream in(path);
+        if (!in.is_open())
+        {
+            LOG_ERROR("Failed to open trace file %s", path.c_str());
+            return trace;
+        }
+
+        
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (line.empty() || line[0] == '#')
+            {
+                continue;
+            }
+
+            std::istringstream fields(line);
+            VirtualPageNumber vpn;
+            std::string mode;
+            if (!(fields >> vpn))
+            {
+                continue;
+            }
+            fields >> mode;
+            trace.push_back({vpn, mode == "w" || mode == "W"});
+        }
+
+        LOG_INFO("Loaded %zu accesses from trace %s", trace.size(), path.c_str());
+        return trace;
+    }
+
+    bool TraceSimulator::save_trace(const std::vector<TraceAccess> &trace, const std::string &path)
+    {
+        std::ofstream out(path);
+        if (!out.is_open())
+        {
+            LOG_ERROR("Failed to open trace file %s for writing", path.c_str());
+            return false;
+        }
+
+        out << "# vpn r|w\n";
+        for (const auto &access : trace)
+        {
+            out << access.vpn << (access.is_write ? " w\n" : " r\n");
+        }
+        return true;
+    }
+
+}
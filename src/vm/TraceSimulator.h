@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Common.h"
+#include "Policies.h"
+#include <string>
+
+namespace uvm_sim
+{
+
+    struct TraceAccess
+    {
+        VirtualPageNumber vpn;
+        bool is_write;
+    };
+
+    
+    
+    
+
+    class TraceSimulator
+    {
+    public:
+        struct Config
+        {
+            size_t gpu_frames = 1024;
+            size_t page_size = DEFAULT_PAGE_SIZE;
+            size_t trace_page_size = DEFAULT_PAGE_SIZE; // granularity the trace was recorded at
+        };
+
+        struct Result
+        {
+            std::string policy;
+            size_t gpu_frames = 0;
+            size_t page_size = 0;
+            uint64_t accesses = 0;
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t evictions = 0;
+            uint64_t writebacks = 0;
+            uint64_t migrated_bytes = 0;
+            uint64_t elapsed_us = 0;
+
+            double miss_rate() const { return accesses ? (double)misses / (double)accesses : 0.0; }
+            double accesses_per_sec() const { return elapsed_us ? accesses * 1e6 / (double)elapsed_us : 0.0; }
+        };
+
+        explicit TraceSimulator(const Config &config = Config());
+
+        
+        Result run(const std::vector<TraceAccess> &trace, ReplacementPolicy &policy, const std::string &name) const;
+
+        
+        Result run_optimal(const std::vector<TraceAccess> &trace) const;
+
+        
+        static std::vector<TraceAccess> load_trace(const std::string &path);
+        static bool save_trace(const std::vector<TraceAccess> &trace, const std::string &path);
+
+        const Config &get_config() const { return config_; }
+
+    private:
+        Config config_;
+
+        std::vector<TraceAccess> rescale(const std::vector<TraceAccess> &trace) const;
+        Result replay(const std::vector<TraceAccess> &trace, ReplacementPolicy &policy, const std::string &name) const;
+    };
+
+}
@@ -0,0 +1,118 @@
+#include "TreePrefetcher.h"
+
+namespace uvm_sim
+{
+
+    TreePrefetcher::TreePrefetcher(const Config &config, size_t page_size) : config_(config)
+    {
+        // Round down to a power of two so every subtree is a full binary tree.
+        size_t pages = std::max<size_t>(config_.region_bytes / page_size, 1);
+        region_pages_ = 1;
+        num_levels_ = 1;
+        while (region_pages_ * 2 <= pages)
+        {
+            region_pages_ *= 2;
+            num_levels_++;
+        }
+        promotions_.resize(num_levels_, 0);
+    }
+
+    TreePrefetcher::Promotion TreePrefetcher::on_fault(VirtualPageNumber vpn)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        Promotion promotion;
+        size_t missing = 0;
+        auto it = resident_.find(vpn / region_pages_);
+        const std::vector<uint64_t> *bits = it == resident_.end() ? nullptr : &it->second;
+
+        size_t offset = vpn % region_pages_;
+        bool faulting_resident = bits && ((*bits)[offset / 64] >> (offset % 64) & 1);
+        for (uint32_t level = 1; level < num_levels_; level++)
+        {
+            size_t size = (size_t)1 << level;
+            size_t first = offset & ~(size - 1);
+            size_t resident = (bits ? count_resident(*bits, first, first + size) : 0) + !faulting_resident;
+            if ((double)resident <= config_.density_threshold * size)
+            {
+                continue;
+            }
+
+            // Keep the largest dense subtree that still has pages to bring in.
+            if (resident < size)
+            {
+                promotion.start = vpn - offset + first;
+                promotion.num_pages = size;
+                promotion.level = level;
+                missing = size - resident;
+            }
+        }
+
+        if (promotion.num_pages)
+        {
+            promotions_[promotion.level]++;
+            pages_promoted_ += missing;
+        }
+        return promotion;
+    }
+
+    void TreePrefetcher::on_resident(VirtualPageNumber vpn)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &bits = resident_[vpn / region_pages_];
+        if (bits.empty())
+        {
+            bits.resize((region_pages_ + 63) / 64, 0);
+        }
+        size_t offset = vpn % region_pages_;
+        bits[offset / 64] |= 1ULL << (offset % 64);
+    }
+
+    void TreePrefetcher::on_evicted(VirtualPageNumber vpn)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = resident_.find(vpn / region_pages_);
+        if (it == resident_.end())
+        {
+            return;
+        }
+
+        size_t offset = vpn % region_pages_;
+        it->second[offset / 64] &= ~(1ULL << (offset % 64));
+        if (std::all_of(it->second.begin(), it->second.end(), [](uint64_t word)
+                        { return word == 0; }))
+        {
+            resident_.erase(it);
+        }
+    }
+
+    void TreePrefetcher::reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        resident_.clear();
+        std::fill(promotions_.begin(), promotions_.end(), 0);
+        pages_promoted_ = 0;
+    }
+
+    uint64_t TreePrefetcher::get_promotions(uint32_t level) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return level < promotions_.size() ? promotions_[level] : 0;
+    }
+
+    size_t TreePrefetcher::count_resident(const std::vector<uint64_t> &bits, size_t first, size_t last) const
+    {
+        size_t count = 0;
+        while (first < last)
+        {
+            size_t word = first / 64;
+            size_t bit = first % 64;
+            size_t span = std::min<size_t>(64 - bit, last - first);
+            uint64_t mask = span == 64 ? ~0ULL : ((1ULL << span) - 1) << bit;
+            count += __builtin_popcountll(bits[word] & mask);
+            first += span;
+        }
+        return count;
+    }
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Common.h"
+
+namespace uvm_sim
+{
+
+    // Density-based prefetching after the NVIDIA UVM driver. The VA space is
+    // cut into regions (2 MB by default), each viewed as a binary tree over its
+    // pages. On a GPU fault, every subtree containing the faulting page is
+    // checked; the largest one whose pages are more than `density_threshold`
+    // GPU-resident, counting the faulting page, is promoted, i.e. its missing
+    // pages are migrated with the fault. Level k covers 2^k pages.
+    class TreePrefetcher
+    {
+    public:
+        struct Config
+        {
+            size_t region_bytes = 2 * 1024 * 1024;
+            double density_threshold = 0.5; // resident fraction a subtree must exceed
+        };
+
+        // Subtree [start, start + num_pages) to migrate; num_pages 0 is none.
+        struct Promotion
+        {
+            VirtualPageNumber start = 0;
+            size_t num_pages = 0;
+            uint32_t level = 0;
+        };
+
+        TreePrefetcher(const Config &config, size_t page_size);
+
+        
+        Promotion on_fault(VirtualPageNumber vpn);
+
+        
+        void on_resident(VirtualPageNumber vpn);
+        void on_evicted(VirtualPageNumber vpn);
+
+        void reset();
+
+        size_t get_region_pages() const { return region_pages_; }
+        uint32_t get_num_levels() const { return num_levels_; }
+        uint64_t get_promotions(uint32_t level) const;
+        uint64_t get_pages_promoted() const { return pages_promoted_.load(std::memory_order_relaxed); }
+        const Config &get_config() const { return config_; }
+
+    private:
+        size_t count_resident(const std::vector<uint64_t> &bits, size_t first, size_t last) const;
+
+        Config config_;
+        size_t region_pages_;
+        uint32_t num_levels_;
+        std::unordered_map<uint64_t, std::vector<uint64_t>> resident_; // bitmap per region
+        std::vector<uint64_t> promotions_;                              // per level
+        mutable std::mutex mutex_;
+
+        std::atomic<uint64_t> pages_promoted_{0}; // non-resident pages in promoted subtrees
+    };
+
+}
@@ -1,10 +1,65 @@
 #include "VirtualMemoryManager.h"
+#include <cmath>
 #include <cstring>
 #include <numeric>
+#include <optional>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace uvm_sim
 {
 
+    namespace
+    {
+        // Set by the fault path; the faulting thread sleeps once it has dropped the manager lock.
+        thread_local uint64_t pending_throttle_us = 0;
+
+        // Pages locked and copied as one batch by prefetch_range and the fault-path
+        // prefetchers, so a long range does not hold every page lock for the whole transfer.
+        constexpr size_t PREFETCH_CHUNK_PAGES = 64;
+
+        bool is_all_zero(const uint8_t *data, size_t bytes)
+        {
+            return bytes == 0 || (data[0] == 0 && std::memcmp(data, data + 1, bytes - 1) == 0);
+        }
+
+        // Large host copies use non-temporal stores so streaming a multi-GB input
+        // through managed buffers does not flush the caller's working set.
+        void host_copy(void *dst, const void *src, size_t bytes, bool streaming)
+        {
+#if defined(__SSE2__)
+            if (streaming)
+            {
+                auto *d = static_cast<uint8_t *>(dst);
+                auto *s = static_cast<const uint8_t *>(src);
+                size_t head = std::min(bytes, (16 - ((uintptr_t)d & 15)) & 15);
+                std::memcpy(d, s, head);
+                d += head;
+                s += head;
+                bytes -= head;
+                for (; bytes >= 64; bytes -= 64, d += 64, s += 64)
+                {
+                    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+                    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 16));
+                    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 32));
+                    __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 48));
+                    _mm_stream_si128(reinterpret_cast<__m128i *>(d), a);
+                    _mm_stream_si128(reinterpret_cast<__m128i *>(d + 16), b);
+                    _mm_stream_si128(reinterpret_cast<__m128i *>(d + 32), c);
+                    _mm_stream_si128(reinterpret_cast<__m128i *>(d + 48), e);
+                }
+                std::memcpy(d, s, bytes);
+                _mm_sfence();
+                return;
+            }
+#endif
+            (void)streaming;
+            std::memcpy(dst, src, bytes);
+        }
+    }
+
     VirtualMemoryManager &VirtualMemoryManager::instance()
     {
         static VirtualMemoryManager instance;
@@ -24,6 +79,18 @@ namespace uvm_sim
         config_ = config;
         Logger::instance().set_level(config_.log_level);
 
+        if (config_.dirty_granule_size)
+        {
+            // One bit per granule in a 64-bit mask.
+            config_.dirty_granule_size = std::max(config_.dirty_granule_size, config_.page_size / 64);
+            if (config_.dirty_granule_size >= config_.page_size || config_.page_size % config_.dirty_granule_size)
+            {
+                LOG_WARN("Dirty granule size %zu does not divide page size %zu, tracking whole pages",
+                         config_.dirty_granule_size, config_.page_size);
+                config_.dirty_granule_size = 0;
+            }
+        }
+
         LOG_INFO("Initializing VirtualMemoryManager with config:");
         LOG_INFO("  Page size: %zu bytes", config_.page_size);
         LOG_INFO("  Virtual address space: %zu bytes", config_.virtual_address_space);
@@ -31,6 +98,8 @@ namespace uvm_sim
         LOG_INFO("  TLB size: %zu entries", config_.tlb_size);
         LOG_INFO("  Replacement policy: %s", config_.replacement_policy == PageReplacementPolicy::LRU ? "LRU" : "CLOCK");
         LOG_INFO("  GPU simulator mode: %s", config_.use_gpu_simulator ? "ON" : "OFF");
+        LOG_INFO("  Link model: %s (H2D %.1f GB/s, D2H %.1f GB/s)", config_.link.name,
+                 config_.link.h2d_bandwidth_gbps, config_.link.d2h_bandwidth_gbps);
 
         
         page_table_ = std::make_unique<PageTable>(config_.page_size);
@@ -38,10 +107,11 @@ namespace uvm_sim
 
         PageAllocator::Config alloc_config;
         alloc_config.page_size = config_.page_size;
-        alloc_config.cpu_page_pool_size = config_.gpu_memory; 
+        alloc_config.cpu_page_pool_size = config_.cpu_memory ? config_.cpu_memory : config_.gpu_memory;
         alloc_config.gpu_page_pool_size = config_.gpu_memory;
         alloc_config.use_pinned_memory = config_.use_pinned_memory;
         alloc_config.use_gpu_simulator = config_.use_gpu_simulator;
+        alloc_config.max_pinned_gpu_fraction = config_.max_pinned_gpu_fraction;
 
         allocator_ = std::make_unique<PageAllocator>(alloc_config);
         allocator_->initialize();
@@ -55,21 +125,84 @@ namespace uvm_sim
 
         MigrationManager::Config mig_config;
         mig_config.async_migration = true;
-        mig_config.max_concurrent_migrations = 4;
+        mig_config.h2d_copy_engines = config_.h2d_copy_engines;
+        mig_config.d2h_copy_engines = config_.d2h_copy_engines;
+        mig_config.link = config_.link;
+        mig_config.emulate_transfer_time = config_.emulate_link_timing;
+        mig_config.compression = config_.link_compression;
+        if (config_.enable_background_eviction)
+        {
+            // Let queued writebacks overtake prefetches while the daemon is behind.
+            mig_config.free_frame_reserve = (size_t)std::ceil(config_.background_eviction.low_watermark *
+                                                              allocator_->get_total_gpu_pages());
+        }
 
-        migration_manager_ = std::make_unique<MigrationManager>(page_table_.get(), mig_config);
+        migration_manager_ = std::make_unique<MigrationManager>(page_table_.get(), allocator_.get(), mig_config);
 
         
+        size_t gpu_frames = allocator_->get_total_gpu_pages();
         if (config_.replacement_policy == PageReplacementPolicy::LRU)
         {
-            replacement_policy_ = std::make_unique<LRUPolicy>(65536);
+            replacement_policy_ = std::make_unique<LRUPolicy>(gpu_frames);
         }
         else
         {
-            replacement_policy_ = std::make_unique<CLOCKPolicy>(65536);
+            replacement_policy_ = std::make_unique<CLOCKPolicy>(gpu_frames);
+        }
+
+        if (config_.policy_access_batch > 0)
+        {
+            access_batcher_ = std::make_unique<AccessBatcher>(replacement_policy_.get(), config_.policy_access_batch);
+        }
+
+        if (config_.enable_thrash_detection)
+        {
+            thrash_detector_ = std::make_unique<ThrashDetector>(config_.thrash_detection);
+        }
+
+        if (config_.enable_prefetch)
+        {
+            stride_prefetcher_ = std::make_unique<StridePrefetcher>(config_.prefetch);
+        }
+
+        if (config_.enable_tree_prefetch)
+        {
+            tree_prefetcher_ = std::make_unique<TreePrefetcher>(config_.tree_prefetch, config_.page_size);
+            LOG_INFO("  Tree prefetch: %zu-page regions, density > %.2f", tree_prefetcher_->get_region_pages(),
+                     config_.tree_prefetch.density_threshold);
+        }
+
+        if (config_.enable_admission_filter)
+        {
+            admission_filter_ = std::make_unique<TinyLFUAdmissionFilter>(gpu_frames);
+            LOG_INFO("  Admission filter: TinyLFU (%zu bytes of counters)", admission_filter_->size_bytes());
+        }
+
+        if (config_.enable_background_eviction)
+        {
+            eviction_daemon_ = std::make_unique<EvictionDaemon>(
+                config_.background_eviction, gpu_frames,
+                [this]()
+                { return allocator_->get_available_gpu_pages(); },
+                [this](size_t max_pages)
+                { return reclaim_gpu_frames(max_pages); });
+            LOG_INFO("  Background eviction: %zu/%zu free-frame watermarks",
+                     eviction_daemon_->get_low_watermark_pages(), eviction_daemon_->get_high_watermark_pages());
         }
 
-        next_vpn_ = 0;
+        default_stream_ = std::make_unique<Stream>();
+
+        if (config_.enable_fault_buffer)
+        {
+            fault_buffer_ = std::make_shared<FaultBuffer>(
+                config_.fault_buffer,
+                [this](const std::vector<VirtualPageNumber> &vpns, std::vector<uint64_t> &throttle_us)
+                { service_fault_batch(vpns, throttle_us); });
+            LOG_INFO("  Fault buffer: batches of up to %zu faults", config_.fault_buffer.batch_size);
+        }
+
+        // VPN 0 is reserved: replacement policies return it as "no victim".
+        next_vpn_ = 1;
         initialized_ = true;
 
         LOG_INFO("VirtualMemoryManager initialized successfully");
@@ -77,6 +210,12 @@ namespace uvm_sim
 
     void VirtualMemoryManager::shutdown()
     {
+        // The daemon, the fault buffer and the default stream work under the
+        // manager lock, so stop them before taking the lock.
+        eviction_daemon_.reset();
+        fault_buffer_.reset();
+        default_stream_.reset();
+
         std::unique_lock<std::shared_mutex> lock(manager_mutex_);
 
         if (!initialized_)
@@ -87,6 +226,11 @@ namespace uvm_sim
         LOG_INFO("Shutting down VirtualMemoryManager");
 
         migration_manager_.reset();
+        admission_filter_.reset();
+        stride_prefetcher_.reset();
+        tree_prefetcher_.reset();
+        thrash_detector_.reset();
+        access_batcher_.reset();
         replacement_policy_.reset();
         tlb_.reset();
         allocator_.reset();
@@ -94,6 +238,7 @@ namespace uvm_sim
 
         vaddr_to_vpn_map_.clear();
         gpu_resident_pages_.clear();
+        access_trace_.clear();
 
         initialized_ = false;
         LOG_INFO("VirtualMemoryManager shutdown complete");
@@ -101,7 +246,7 @@ namespace uvm_sim
 
     void *VirtualMemoryManager::allocate(size_t bytes, bool prefetch_to_gpu)
     {
-        std::unique_lock<std::shared_mutex> lock(manager_mutex_);
+        std::shared_lock<std::shared_mutex> lock(manager_mutex_);
 
         if (!initialized_)
         {
@@ -111,10 +256,14 @@ namespace uvm_sim
 
         size_t aligned_size = align_to_page(bytes, config_.page_size);
         uint32_t num_pages = aligned_size / config_.page_size;
+        std::unique_lock<std::mutex> alloc_lock(alloc_mutex_);
         VirtualPageNumber vpn_start = next_vpn_;
 
-        
-        if (!page_table_->allocate_vpn_range(vpn_start, num_pages))
+        // Demand-paged by default: only the VPN range is reserved and each page
+        // gets a frame on whichever side touches it first.
+        bool reserved = config_.eager_population ? page_table_->allocate_vpn_range(vpn_start, num_pages)
+                                                 : page_table_->reserve_vpn_range(vpn_start, num_pages);
+        if (!reserved)
         {
             LOG_ERROR("Failed to allocate VPN range");
             return nullptr;
@@ -122,8 +271,17 @@ namespace uvm_sim
 
         
         std::vector<void *> cpu_pages;
-        for (uint32_t i = 0; i < num_pages; i++)
+        for (uint32_t i = 0; i < num_pages && config_.eager_population; i++)
         {
+            VirtualPageNumber vpn = vpn_start + i;
+            if (config_.zero_fill_on_demand)
+            {
+                // Backed on first write; until then reads map the shared zero frame.
+                page_table_->lookup_entry(vpn)->is_zero = true;
+                page_table_->update_access_time(vpn);
+                continue;
+            }
+
             void *cpu_page = allocator_->allocate_cpu_page();
             if (!cpu_page)
             {
@@ -137,45 +295,23 @@ namespace uvm_sim
             }
             cpu_pages.push_back(cpu_page);
 
-            VirtualPageNumber vpn = vpn_start + i;
             page_table_->set_cpu_resident(vpn, cpu_page);
             page_table_->update_access_time(vpn);
-
-            replacement_policy_->on_page_allocated(vpn);
-        }
-
-        
-        if (prefetch_to_gpu)
-        {
-            for (uint32_t i = 0; i < num_pages; i++)
-            {
-                uint64_t gpu_addr = allocator_->allocate_gpu_page();
-                if (gpu_addr == 0)
-                {
-                    LOG_WARN("Failed to allocate GPU page %u", i);
-                    continue;
-                }
-
-                VirtualPageNumber vpn = vpn_start + i;
-                page_table_->set_gpu_resident(vpn, gpu_addr);
-                gpu_resident_pages_.insert(vpn);
-
-                
-                uint64_t mig_time =
-                    migration_manager_->migrate_cpu_to_gpu(vpn, cpu_pages[i], gpu_addr, config_.page_size);
-                perf_counters_.cpu_to_gpu_migrations++;
-                perf_counters_.total_bytes_migrated += config_.page_size;
-                perf_counters_.total_migration_time_us += mig_time;
-
-                perf_counters_.page_prefetches++;
-            }
         }
 
         
         Address vaddr = vpn_to_vaddr(vpn_start, config_.page_size);
-        vaddr_to_vpn_map_[vaddr] = vpn_start;
+        vaddr_to_vpn_map_[vaddr] = {vpn_start, num_pages};
 
         next_vpn_ += num_pages;
+        alloc_lock.unlock();
+
+        
+        if (prefetch_to_gpu)
+        {
+            PageRangeLock range_lock(page_locks_, vpn_start, num_pages);
+            perf_counters_.page_prefetches += migrate_range_to_gpu(vpn_start, num_pages, MigrationPriority::PREFETCH).size();
+        }
 
         LOG_DEBUG("Allocated virtual memory: vaddr=%p, size=%zu bytes, num_pages=%u", (void *)vaddr, bytes, num_pages);
 
@@ -184,7 +320,7 @@ namespace uvm_sim
 
     void VirtualMemoryManager::free(void *vaddr)
     {
-        std::unique_lock<std::shared_mutex> lock(manager_mutex_);
+        std::shared_lock<std::shared_mutex> lock(manager_mutex_);
 
         if (!initialized_)
         {
@@ -192,66 +328,79 @@ namespace uvm_sim
             return;
         }
 
-        Address addr = (Address)vaddr;
-        auto it = vaddr_to_vpn_map_.find(addr);
-        if (it == vaddr_to_vpn_map_.end())
-        {
-            LOG_WARN("Freeing unmapped virtual address %p", vaddr);
-            return;
-        }
-
-        VirtualPageNumber vpn_start = it->second;
-
-        
-        auto entries = page_table_->get_all_entries();
-        uint32_t num_pages = 0;
-        for (auto &entry : entries)
+        Allocation allocation;
         {
-            if (entry.first >= vpn_start && entry.second && entry.second->is_valid)
+            std::lock_guard<std::mutex> alloc_lock(alloc_mutex_);
+            auto it = vaddr_to_vpn_map_.find((Address)vaddr);
+            if (it == vaddr_to_vpn_map_.end())
             {
-                num_pages++;
+                LOG_WARN("Freeing unmapped virtual address %p", vaddr);
+                return;
             }
+            allocation = it->second;
+            vaddr_to_vpn_map_.erase(it);
         }
 
-        if (num_pages == 0)
-        {
-            num_pages = 1; 
-        }
+        VirtualPageNumber vpn_start = allocation.vpn_start;
+        uint32_t num_pages = allocation.num_pages;
 
         
+        std::optional<PageRangeLock> range_lock;
+        lock_settled(range_lock, vpn_start, num_pages);
+        const PageTable &table = *page_table_;
         for (uint32_t i = 0; i < num_pages; i++)
         {
             VirtualPageNumber vpn = vpn_start + i;
-            auto entry = page_table_->lookup_entry(vpn);
-            if (entry && entry->cpu_address)
+            const PageTableEntry *entry = table.get_entry(vpn);
+            if (!entry)
+            {
+                continue; // never populated
+            }
+            if (entry->pin_count > 0)
+            {
+                allocator_->unpin_gpu_page();
+            }
+            if (entry->cpu_address && !entry->is_zero)
             {
                 allocator_->deallocate_cpu_page(entry->cpu_address);
             }
-            if (entry && entry->gpu_address != 0)
+            if (entry->gpu_address != 0)
             {
                 allocator_->deallocate_gpu_page(entry->gpu_address);
+                if (tree_prefetcher_)
+                {
+                    tree_prefetcher_->on_evicted(vpn);
+                }
             }
 
-            gpu_resident_pages_.erase(vpn);
+            {
+                std::lock_guard<std::mutex> residency_lock(residency_mutex_);
+                gpu_resident_pages_.erase(vpn);
+            }
             replacement_policy_->on_page_freed(vpn);
+            if (thrash_detector_)
+            {
+                thrash_detector_->on_page_freed(vpn);
+            }
             tlb_->invalidate(vpn);
         }
 
         page_table_->deallocate_vpn_range(vpn_start, num_pages);
-        vaddr_to_vpn_map_.erase(it);
 
         LOG_DEBUG("Freed virtual memory: vaddr=%p, num_pages=%u", vaddr, num_pages);
     }
 
     void VirtualMemoryManager::map_to_cpu(void *vaddr, bool prefetch)
     {
-        std::unique_lock<std::shared_mutex> lock(manager_mutex_);
+        std::shared_lock<std::shared_mutex> lock(manager_mutex_);
 
         if (!initialized_)
             return;
 
         Address addr = (Address)vaddr;
         VirtualPageNumber vpn = vaddr_to_vpn(addr, config_.page_size);
+        std::optional<PageRangeLock> page_lock;
+        lock_settled(page_lock, vpn, 1);
 
         auto entry = page_table_->lookup_entry(vpn);
         if (!entry)
@@ -266,44 +415,24 @@ namespace uvm_sim
 
     void VirtualMemoryManager::map_to_gpu(void *vaddr)
     {
-        std::unique_lock<std::shared_mutex> lock(manager_mutex_);
+        std::shared_lock<std::shared_mutex> lock(manager_mutex_);
 
         if (!initialized_)
             return;
 
         Address addr = (Address)vaddr;
         VirtualPageNumber vpn = vaddr_to_vpn(addr, config_.page_size);
+        std::optional<PageRangeLock> page_lock;
+        lock_settled(page_lock, vpn, 1);
 
         auto entry = page_table_->lookup_entry(vpn);
         if (!entry)
             return;
 
         
-        if (!entry->resident_on_gpu)
+        if (!entry->resident_on_gpu || entry->cpu_dirty)
         {
-            
-            if (entry->gpu_address == 0)
-            {
-                entry->gpu_address = allocator_->allocate_gpu_page();
-                if (entry->gpu_address == 0)
-                {
-                    evict_page_from_gpu();
-                    entry->gpu_address = allocator_->allocate_gpu_page();
-                }
-            }
-
-            
-            if (entry->resident_on_cpu)
-            {
-                uint64_t mig_time =
-                    migration_manager_->migrate_cpu_to_gpu(vpn, entry->cpu_address, entry->gpu_address, config_.page_size);
-                perf_counters_.cpu_to_gpu_migrations++;
-                perf_counters_.total_bytes_migrated += config_.page_size;
-                perf_counters_.total_migration_time_us += mig_time;
-            }
-
-            entry->resident_on_gpu = true;
-            gpu_resident_pages_.insert(vpn);
+            resolve_page_fault(vpn, true, false);
         }
     }
 
@@ -312,212 +441,1488 @@ namespace uvm_sim
         map_to_gpu(vaddr);
     }
 
-    void VirtualMemoryManager::touch_page(void *vaddr, bool is_write)
+    void VirtualMemoryManager::prefetch_to_gpu(void *vaddr, size_t bytes)
     {
-        std::unique_lock<std::shared_mutex> lock(manager_mutex_);
+        std::shared_lock<std::shared_mutex> lock(manager_mutex_);
 
-        if (!initialized_)
+        if (!initialized_ || !vaddr || bytes == 0)
             return;
 
         Address addr = (Address)vaddr;
-        VirtualPageNumber vpn = vaddr_to_vpn(addr, config_.page_size);
+        VirtualPageNumber vpn_start = vaddr_to_vpn(addr, config_.page_size);
+        VirtualPageNumber vpn_end = vaddr_to_vpn(addr + bytes - 1, config_.page_size);
 
-        auto entry = page_table_->lookup_entry(vpn);
-        if (!entry)
+        size_t num_pages = vpn_end - vpn_start + 1;
+        for (size_t done = 0; done < num_pages; done += PREFETCH_CHUNK_PAGES)
         {
-            perf_counters_.total_page_faults++;
-            resolve_page_fault(vpn, false); 
-            entry = page_table_->lookup_entry(vpn);
+            size_t chunk = std::min(PREFETCH_CHUNK_PAGES, num_pages - done);
+            std::optional<PageRangeLock> range_lock;
+            lock_settled(range_lock, vpn_start + done, chunk);
+            auto moved = migrate_range_to_gpu(vpn_start + done, chunk, MigrationPriority::PREFETCH, &range_lock);
+            perf_counters_.page_prefetches += moved.size();
         }
+    }
 
-        if (entry)
+    Event VirtualMemoryManager::prefetch_range(void *base, size_t bytes, Location dst, Stream *stream)
+    {
+        std::shared_lock<std::shared_mutex> lock(manager_mutex_);
+
+        if (!initialized_ || !base || bytes == 0)
+            return Event();
+
+        if (!stream)
         {
-            entry->access_timestamp_us = get_timestamp_us();
-            entry->access_count++;
-            if (is_write)
+            stream = default_stream_.get();
+        }
+
+        Address addr = (Address)base;
+        VirtualPageNumber vpn_start = vaddr_to_vpn(addr, config_.page_size);
+        size_t num_pages = vaddr_to_vpn(addr + bytes - 1, config_.page_size) - vpn_start + 1;
+
+        stream->enqueue([this, vpn_start, num_pages, dst]()
+                        {
+            std::shared_lock<std::shared_mutex> lock(manager_mutex_);
+            if (!initialized_)
+                return;
+
+            for (size_t done = 0; done < num_pages; done += PREFETCH_CHUNK_PAGES)
             {
-                entry->is_dirty = true;
-            }
-            replacement_policy_->on_page_access(vpn);
+                size_t chunk = std::min(PREFETCH_CHUNK_PAGES, num_pages - done);
+                std::optional<PageRangeLock> range_lock;
+                lock_settled(range_lock, vpn_start + done, chunk);
+                if (dst == Location::GPU)
+                {
+                    auto moved = migrate_range_to_gpu(vpn_start + done, chunk, MigrationPriority::PREFETCH, &range_lock);
+                    perf_counters_.page_prefetches += moved.size();
+                }
+                else
+                {
+                    perf_counters_.page_prefetches += migrate_range_to_cpu(vpn_start + done, chunk);
+                }
+            } });
+
+        Event event = stream->record();
+        if (stream != default_stream_.get())
+        {
+            // Caller streams may be gone by the time sync_all_migrations runs, so keep the event.
+            std::lock_guard<std::mutex> prefetches_lock(stream_prefetches_mutex_);
+            stream_prefetches_.erase(std::remove_if(stream_prefetches_.begin(), stream_prefetches_.end(), [](const Event &e)
+                                                    { return e.query(); }),
+                                     stream_prefetches_.end());
+            stream_prefetches_.push_back(event);
         }
+        return event;
     }
 
-    void VirtualMemoryManager::read_from_vaddr(void *vaddr, void *buffer, size_t bytes)
+    void VirtualMemoryManager::advise(void *base, size_t bytes, Advice advice, Location location)
     {
-        std::unique_lock<std::shared_mutex> lock(manager_mutex_);
+        std::shared_lock<std::shared_mutex> lock(manager_mutex_);
 
-        if (!initialized_ || !vaddr || !buffer)
+        if (!initialized_ || !base || bytes == 0)
             return;
 
-        
-        Address addr = (Address)vaddr;
-        VirtualPageNumber vpn = vaddr_to_vpn(addr, config_.page_size);
+        Address addr = (Address)base;
+        VirtualPageNumber vpn_start = vaddr_to_vpn(addr, config_.page_size);
+        VirtualPageNumber vpn_end = vaddr_to_vpn(addr + bytes - 1, config_.page_size);
+        std::optional<PageRangeLock> range_lock;
+        lock_settled(range_lock, vpn_start, vpn_end - vpn_start + 1);
 
-        auto entry = page_table_->lookup_entry(vpn);
-        if (!entry)
+        bool gpu = location == Location::GPU;
+        for (VirtualPageNumber vpn = vpn_start; vpn <= vpn_end; vpn++)
         {
-            LOG_ERROR("Invalid virtual address");
-            return;
+            auto entry = page_table_->lookup_entry(vpn);
+            if (!entry)
+            {
+                LOG_WARN("advise: VPN %lu is not allocated", vpn);
+                continue;
+            }
+
+            switch (advice)
+            {
+            case Advice::SET_READ_MOSTLY:
+                entry->read_mostly = true;
+                break;
+            case Advice::UNSET_READ_MOSTLY:
+                entry->read_mostly = false;
+                break;
+            case Advice::SET_PREFERRED_LOCATION:
+                entry->preferred_gpu = gpu;
+                entry->preferred_cpu = !gpu;
+                break;
+            case Advice::UNSET_PREFERRED_LOCATION:
+                entry->preferred_gpu = false;
+                entry->preferred_cpu = false;
+                break;
+            case Advice::SET_ACCESSED_BY:
+                entry->accessed_by_gpu = entry->accessed_by_gpu || gpu;
+                break;
+            case Advice::UNSET_ACCESSED_BY:
+                entry->accessed_by_gpu = entry->accessed_by_gpu && !gpu;
+                break;
+            }
         }
+    }
 
-        if (!entry->resident_on_cpu)
+    PageResidency VirtualMemoryManager::get_residency(void *vaddr)
+    {
+        std::shared_lock<std::shared_mutex> lock(manager_mutex_);
+
+        if (!initialized_)
+            return PageResidency::UNALLOCATED;
+
+        VirtualPageNumber vpn = vaddr_to_vpn((Address)vaddr, config_.page_size);
+        std::optional<PageRangeLock> page_lock;
+        lock_settled(page_lock, vpn, 1);
+        auto entry = page_table_->lookup_entry(vpn);
+        if (!entry)
         {
-            resolve_page_fault(vpn, false);
-            entry = page_table_->lookup_entry(vpn);
+            return PageResidency::UNALLOCATED;
         }
 
-        if (entry && entry->cpu_address)
+        // A side counts only while its copy is current.
+        bool on_cpu = entry->resident_on_cpu && !entry->gpu_dirty;
+        bool on_gpu = entry->resident_on_gpu && !entry->cpu_dirty;
+        if (on_cpu && on_gpu)
+            return PageResidency::BOTH;
+        if (on_gpu)
+            return PageResidency::GPU_ONLY;
+        return on_cpu ? PageResidency::CPU_ONLY : PageResidency::UNALLOCATED;
+    }
+
+    bool VirtualMemoryManager::pin(void *vaddr, size_t bytes)
+    {
+        std::shared_lock<std::shared_mutex> lock(manager_mutex_);
+
+        if (!initialized_ || !vaddr || bytes == 0)
+            return false;
+
+        Address addr = (Address)vaddr;
+        VirtualPageNumber vpn_start = vaddr_to_vpn(addr, config_.page_size);
+        VirtualPageNumber vpn_end = vaddr_to_vpn(addr + bytes - 1, config_.page_size);
+        std::optional<PageRangeLock> range_lock;
+        lock_settled(range_lock, vpn_start, vpn_end - vpn_start + 1);
+
+        for (VirtualPageNumber vpn = vpn_start; vpn <= vpn_end; vpn++)
         {
-            std::memcpy(buffer, entry->cpu_address, bytes);
-            entry->access_timestamp_us = get_timestamp_us();
+            if (!pin_page(vpn))
+            {
+                LOG_WARN("Failed to pin VPN %lu, rolling back pin of [%lu, %lu]", vpn, vpn_start, vpn_end);
+                while (vpn-- > vpn_start)
+                {
+                    unpin_page(vpn);
+                }
+                return false;
+            }
         }
+
+        LOG_DEBUG("Pinned VPN range [%lu, %lu] on GPU", vpn_start, vpn_end);
+        return true;
     }
 
-    void VirtualMemoryManager::write_to_vaddr(void *vaddr, const void *buffer, size_t bytes)
+    void VirtualMemoryManager::unpin(void *vaddr, size_t bytes)
     {
-        std::unique_lock<std::shared_mutex> lock(manager_mutex_);
+        std::shared_lock<std::shared_mutex> lock(manager_mutex_);
 
-        if (!initialized_ || !vaddr || !buffer)
+        if (!initialized_ || !vaddr || bytes == 0)
             return;
 
         Address addr = (Address)vaddr;
-        VirtualPageNumber vpn = vaddr_to_vpn(addr, config_.page_size);
+        VirtualPageNumber vpn_start = vaddr_to_vpn(addr, config_.page_size);
+        VirtualPageNumber vpn_end = vaddr_to_vpn(addr + bytes - 1, config_.page_size);
+        std::optional<PageRangeLock> range_lock;
+        lock_settled(range_lock, vpn_start, vpn_end - vpn_start + 1);
+
+        for (VirtualPageNumber vpn = vpn_start; vpn <= vpn_end; vpn++)
+        {
+            unpin_page(vpn);
+        }
+    }
 
+    bool VirtualMemoryManager::pin_page(VirtualPageNumber vpn)
+    {
         auto entry = page_table_->lookup_entry(vpn);
         if (!entry)
         {
-            LOG_ERROR("Invalid virtual address");
-            return;
+            return false;
         }
 
-        if (!entry->resident_on_cpu)
+        if (entry->pin_count > 0)
         {
-            resolve_page_fault(vpn, false);
-            entry = page_table_->lookup_entry(vpn);
+            return page_table_->pin(vpn) > 0;
         }
 
-        if (entry && entry->cpu_address)
+        if (!allocator_->pin_gpu_page())
         {
-            std::memcpy(entry->cpu_address, buffer, bytes);
-            entry->is_dirty = true;
-            entry->access_timestamp_us = get_timestamp_us();
+            return false;
+        }
+
+        if (!entry->resident_on_gpu)
+        {
+            resolve_page_fault(vpn, true, false);
+        }
+        if (!entry->resident_on_gpu)
+        {
+            allocator_->unpin_gpu_page();
+            return false;
         }
+
+        page_table_->pin(vpn);
+        replacement_policy_->on_page_pinned(vpn);
+        return true;
     }
 
-    void VirtualMemoryManager::sync_all_migrations()
+    void VirtualMemoryManager::unpin_page(VirtualPageNumber vpn)
     {
-        if (!initialized_)
+        auto entry = page_table_->lookup_entry(vpn);
+        if (!entry || entry->pin_count == 0)
+        {
             return;
+        }
 
-        migration_manager_->wait_for_migrations();
-        LOG_DEBUG("All migrations completed");
+        if (page_table_->unpin(vpn) == 0)
+        {
+            allocator_->unpin_gpu_page();
+            if (entry->resident_on_gpu)
+            {
+                replacement_policy_->on_page_unpinned(vpn);
+            }
+        }
     }
 
-    void VirtualMemoryManager::resolve_page_fault(VirtualPageNumber vpn, bool access_gpu)
+    void VirtualMemoryManager::touch_page(void *vaddr, bool is_write)
     {
+        std::shared_lock<std::shared_mutex> lock(manager_mutex_);
+
+        if (!initialized_)
+            return;
+
+        Address addr = (Address)vaddr;
+        VirtualPageNumber vpn = vaddr_to_vpn(addr, config_.page_size);
+        std::optional<PageRangeLock> page_lock;
+        lock_settled(page_lock, vpn, 1);
+
         auto entry = page_table_->lookup_entry(vpn);
         if (!entry)
         {
-            LOG_ERROR("Page fault on invalid VPN %lu", vpn);
-            return;
+            perf_counters_.total_page_faults++;
+            resolve_page_fault(vpn, true);
+            entry = page_table_->lookup_entry(vpn);
         }
 
-        if (access_gpu)
+        if (entry)
         {
+            if (config_.record_access_trace)
+            {
+                std::lock_guard<std::mutex> trace_lock(trace_mutex_);
+                access_trace_.push_back({vpn, is_write});
+            }
+
+            if (admission_filter_)
+            {
+                admission_filter_->record_access(vpn);
+            }
+
+            if (entry->prefetched)
+            {
+                entry->prefetched = false;
+                if (stride_prefetcher_)
+                {
+                    // First touch of a prefetched page: credit it and keep the window ahead.
+                    stride_prefetcher_->on_useful();
+                    auto prefetch = stride_prefetcher_->on_access(vpn);
+                    issue_prefetch(prefetch.start, prefetch.stride, prefetch.count);
+                }
+            }
+
             
-            if (!entry->resident_on_gpu)
+            if (entry->accessed_by_gpu && !entry->resident_on_gpu && entry->resident_on_cpu)
             {
-                if (entry->gpu_address == 0)
+                // Already mapped for the GPU: read the host copy over the link.
+                perf_counters_.remote_accesses++;
+            }
+            else if (!entry->resident_on_gpu || entry->cpu_dirty)
+            {
+                perf_counters_.total_page_faults++;
+                if (fault_buffer_)
                 {
-                    entry->gpu_address = allocator_->allocate_gpu_page();
-                    if (entry->gpu_address == 0)
+                    // Stall in the fault buffer until its batch is serviced, then replay.
+                    // The servicing thread needs the manager lock, so drop it while waiting.
+                    std::shared_ptr<FaultBuffer> buffer = fault_buffer_;
+                    page_lock.reset();
+                    lock.unlock();
+                    pending_throttle_us = buffer->fault_and_wait(vpn);
+                    lock.lock();
+
+                    if (initialized_)
+                    {
+                        lock_settled(page_lock, vpn, 1);
+                        entry = page_table_->lookup_entry(vpn);
+                    }
+                    if (!initialized_ || !entry)
                     {
-                        evict_page_from_gpu();
-                        entry->gpu_address = allocator_->allocate_gpu_page();
+                        // Freed or shut down while stalled: nothing to replay.
+                        pending_throttle_us = 0;
+                        return;
                     }
                 }
-
-                if (entry->resident_on_cpu)
+                else
                 {
-                    uint64_t mig_time = migration_manager_->migrate_cpu_to_gpu(
-                        vpn, entry->cpu_address, entry->gpu_address, config_.page_size);
-                    perf_counters_.cpu_to_gpu_migrations++;
-                    perf_counters_.total_bytes_migrated += config_.page_size;
-                    perf_counters_.total_migration_time_us += mig_time;
+                    resolve_page_fault(vpn, true);
                 }
-
+                if (!entry->resident_on_gpu)
+                {
+                    perf_counters_.remote_accesses++;
+                }
+            }
+
+            entry->access_timestamp_us = get_timestamp_us();
+            entry->access_count++;
+            if (is_write && entry->resident_on_gpu)
+            {
+                entry->gpu_dirty = true;
+                entry->gpu_dirty_granules |= dirty_granules(addr % config_.page_size, 1);
+            }
+            if (access_batcher_)
+            {
+                access_batcher_->record(vpn);
+            }
+            else
+            {
+                replacement_policy_->on_page_access(vpn);
+            }
+        }
+
+        // Throttle outside the locks so only the thrashing thread is delayed.
+        if (pending_throttle_us)
+        {
+            uint64_t delay_us = pending_throttle_us;
+            pending_throttle_us = 0;
+            page_lock.reset();
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::microseconds(delay_us));
+        }
+    }
+
+    void VirtualMemoryManager::read_from_vaddr(void *vaddr, void *buffer, size_t bytes)
+    {
+        std::shared_lock<std::shared_mutex> lock(manager_mutex_);
+
+        if (!initialized_ || !vaddr || !buffer || bytes == 0)
+            return;
+
+        Address addr = (Address)vaddr;
+        VirtualPageNumber vpn_start = vaddr_to_vpn(addr, config_.page_size);
+        size_t num_pages = vaddr_to_vpn(addr + bytes - 1, config_.page_size) - vpn_start + 1;
+        std::optional<PageRangeLock> range_lock;
+        lock_settled(range_lock, vpn_start, num_pages);
+
+        if (!fault_in_host_range(addr, bytes, false))
+        {
+            LOG_ERROR("Invalid virtual address");
+            return;
+        }
+
+        bool streaming = config_.streaming_copy_threshold && bytes >= config_.streaming_copy_threshold;
+        uint64_t now_us = get_timestamp_us();
+        uint8_t *out = static_cast<uint8_t *>(buffer);
+        for (size_t done = 0; done < bytes;)
+        {
+            size_t offset = (addr + done) % config_.page_size;
+            size_t chunk = std::min(bytes - done, config_.page_size - offset);
+            VirtualPageNumber vpn = vaddr_to_vpn(addr + done, config_.page_size);
+            auto entry = page_table_->lookup_entry(vpn);
+            host_copy(out + done, static_cast<uint8_t *>(entry->cpu_address) + offset, chunk, streaming);
+            entry->access_timestamp_us = now_us;
+
+            // A host read migrates the page back. Read-mostly pages keep both copies
+            // mapped; pinned and GPU-preferred pages keep their device frame as well.
+            if (entry->resident_on_gpu && !entry->read_mostly && !entry->preferred_gpu && entry->pin_count == 0)
+            {
+                replacement_policy_->on_page_freed(vpn);
+                release_gpu_frame(vpn, entry);
+                if (thrash_detector_)
+                {
+                    thrash_detector_->on_eviction(vpn, now_us);
+                }
+            }
+            done += chunk;
+        }
+    }
+
+    void VirtualMemoryManager::write_to_vaddr(void *vaddr, const void *buffer, size_t bytes)
+    {
+        std::shared_lock<std::shared_mutex> lock(manager_mutex_);
+
+        if (!initialized_ || !vaddr || !buffer || bytes == 0)
+            return;
+
+        Address addr = (Address)vaddr;
+        VirtualPageNumber vpn_start = vaddr_to_vpn(addr, config_.page_size);
+        size_t num_pages = vaddr_to_vpn(addr + bytes - 1, config_.page_size) - vpn_start + 1;
+        std::optional<PageRangeLock> range_lock;
+        lock_settled(range_lock, vpn_start, num_pages);
+
+        if (!fault_in_host_range(addr, bytes, true))
+        {
+            LOG_ERROR("Invalid virtual address or no CPU frame for write at %p", vaddr);
+            return;
+        }
+
+        bool streaming = config_.streaming_copy_threshold && bytes >= config_.streaming_copy_threshold;
+        uint64_t now_us = get_timestamp_us();
+        const uint8_t *in = static_cast<const uint8_t *>(buffer);
+        for (size_t done = 0; done < bytes;)
+        {
+            size_t offset = (addr + done) % config_.page_size;
+            size_t chunk = std::min(bytes - done, config_.page_size - offset);
+            VirtualPageNumber vpn = vaddr_to_vpn(addr + done, config_.page_size);
+            auto entry = page_table_->lookup_entry(vpn);
+            host_copy(static_cast<uint8_t *>(entry->cpu_address) + offset, in + done, chunk, streaming);
+            entry->access_timestamp_us = now_us;
+
+            // The device copy is now stale. Pinned pages are refreshed right away,
+            // read-mostly duplicates are dropped, others keep their frame and are
+            // refreshed on the next GPU access.
+            if (entry->resident_on_gpu && entry->read_mostly && entry->pin_count == 0)
+            {
+                replacement_policy_->on_page_freed(vpn);
+                release_gpu_frame(vpn, entry);
+            }
+            else if (entry->resident_on_gpu)
+            {
+                entry->cpu_dirty = true;
+                entry->cpu_dirty_granules |= dirty_granules(offset, chunk);
+                if (entry->pin_count > 0)
+                {
+                    refresh_gpu_copy(vpn, entry);
+                }
+            }
+            done += chunk;
+        }
+    }
+
+    bool VirtualMemoryManager::fault_in_host_range(Address addr, size_t bytes, bool is_write)
+    {
+        VirtualPageNumber vpn_start = vaddr_to_vpn(addr, config_.page_size);
+        VirtualPageNumber vpn_end = vaddr_to_vpn(addr + bytes - 1, config_.page_size);
+
+        std::vector<PageTableEntry *> entries;
+        for (VirtualPageNumber vpn = vpn_start; vpn <= vpn_end; vpn++)
+        {
+            auto entry = page_table_->lookup_entry(vpn);
+            if (!entry)
+            {
+                return false;
+            }
+            entries.push_back(entry);
+        }
+
+        std::vector<MigrationManager::PageTransfer> fetches;
+        for (VirtualPageNumber vpn = vpn_start; vpn <= vpn_end; vpn++)
+        {
+            auto entry = entries[vpn - vpn_start];
+            Address page_addr = vpn_to_vaddr(vpn, config_.page_size);
+            bool overwritten = is_write && addr <= page_addr && addr + bytes >= page_addr + config_.page_size;
+
+            if (overwritten)
+            {
+                // Nothing on either side survives a full-page write, so skip the fetch.
+                entry->gpu_dirty = false;
+                entry->gpu_dirty_granules = 0;
+                if (entry->is_zero && !materialize_cpu_page(entry))
+                {
+                    return false;
+                }
+            }
+            else if (entry->is_zero)
+            {
+                // Unpopulated pages need no copy unless the device has written them.
+                if (!entry->resident_on_cpu)
+                {
+                    resolve_page_fault(vpn, false);
+                }
+                else
+                {
+                    writeback_page(vpn, entry);
+                }
+                if (is_write && entry->is_zero && !materialize_cpu_page(entry))
+                {
+                    return false;
+                }
+                if (!entry->resident_on_cpu)
+                {
+                    return false;
+                }
+                continue;
+            }
+            else if (entry->resident_on_cpu && entry->gpu_dirty && entry->gpu_dirty_granules)
+            {
+                writeback_page(vpn, entry);
+            }
+            else if (entry->resident_on_gpu && (entry->gpu_dirty || !entry->resident_on_cpu))
+            {
+                if (!entry->cpu_address)
+                {
+                    entry->cpu_address = allocator_->allocate_cpu_page();
+                }
+                if (!entry->cpu_address)
+                {
+                    return false;
+                }
+                fetches.push_back({vpn, entry->cpu_address, entry->gpu_address});
+            }
+
+            if (!entry->cpu_address)
+            {
+                entry->cpu_address = allocator_->allocate_cpu_page();
+                if (!entry->cpu_address)
+                {
+                    return false;
+                }
+            }
+            entry->resident_on_cpu = true;
+        }
+
+        if (!fetches.empty())
+        {
+            for (const auto &page : fetches)
+            {
+                auto entry = entries[page.vpn - vpn_start];
+                entry->gpu_dirty = false;
+                entry->gpu_dirty_granules = 0;
+            }
+            auto batch = migration_manager_->migrate_batch_gpu_to_cpu(std::move(fetches), config_.page_size);
+            perf_counters_.gpu_to_cpu_migrations += batch.pages;
+            perf_counters_.total_bytes_migrated += batch.bytes;
+            perf_counters_.total_migration_time_us += batch.time_us;
+            perf_counters_.migration_batches++;
+            perf_counters_.migration_batch_copies += batch.runs;
+        }
+        return true;
+    }
+
+    void VirtualMemoryManager::sync_all_migrations()
+    {
+        if (!initialized_)
+            return;
+
+        // Prefetches and fault-path prefetch windows run on streams, not the migration manager.
+        if (default_stream_)
+        {
+            default_stream_->synchronize();
+        }
+
+        std::vector<Event> prefetches;
+        {
+            std::lock_guard<std::mutex> lock(stream_prefetches_mutex_);
+            prefetches.swap(stream_prefetches_);
+        }
+        for (const auto &event : prefetches)
+        {
+            event.synchronize();
+        }
+
+        migration_manager_->wait_for_migrations();
+        LOG_DEBUG("All migrations completed");
+    }
+
+    void VirtualMemoryManager::resolve_page_fault(VirtualPageNumber vpn, bool access_gpu, bool demand)
+    {
+        auto entry = page_table_->lookup_entry(vpn);
+        if (!entry)
+        {
+            LOG_ERROR("Page fault on invalid VPN %lu", vpn);
+            return;
+        }
+
+        if (access_gpu)
+        {
+            
+            if (!entry->resident_on_gpu)
+            {
+                if (demand && serve_gpu_fault_remotely(vpn, entry))
+                {
+                    return;
+                }
+
+                if (entry->gpu_address == 0 && acquire_gpu_frame(vpn, entry, demand) != FrameResult::ACQUIRED)
+                {
+                    return;
+                }
+
+                if (entry->is_zero)
+                {
+                    zero_fill_gpu_frame(entry);
+                }
+                else if (entry->resident_on_cpu)
+                {
+                    uint64_t mig_time = migration_manager_->migrate_cpu_to_gpu(
+                        vpn, entry->cpu_address, entry->gpu_address, config_.page_size);
+                    perf_counters_.cpu_to_gpu_migrations++;
+                    perf_counters_.total_bytes_migrated += config_.page_size;
+                    perf_counters_.total_migration_time_us += mig_time;
+                }
+
                 entry->resident_on_gpu = true;
-                gpu_resident_pages_.insert(vpn);
+                {
+                    std::lock_guard<std::mutex> residency_lock(residency_mutex_);
+                    gpu_resident_pages_.insert(vpn);
+                }
+                replacement_policy_->on_page_allocated(vpn);
+                if (tree_prefetcher_)
+                {
+                    tree_prefetcher_->on_resident(vpn);
+                }
+
+                if (demand)
+                {
+                    run_fault_prefetchers(vpn);
+                }
+            }
+            else
+            {
+                refresh_gpu_copy(vpn, entry);
+            }
+        }
+        else
+        {
+            
+            if (!entry->resident_on_cpu && entry->is_zero)
+            {
+                // Unless the device copy holds data, a first host touch either shares
+                // the zero frame or places a private frame on the host.
+                writeback_page(vpn, entry);
+                if (entry->is_zero && config_.zero_fill_on_demand)
+                {
+                    map_zero_page(entry);
+                }
+                else if (entry->is_zero && materialize_cpu_page(entry))
+                {
+                    entry->resident_on_cpu = true;
+                }
+            }
+            else if (!entry->resident_on_cpu)
+            {
+                if (entry->cpu_address == nullptr)
+                {
+                    entry->cpu_address = allocator_->allocate_cpu_page();
+                }
+
+                if (entry->resident_on_gpu)
+                {
+                    uint64_t mig_time = migration_manager_->migrate_gpu_to_cpu(
+                        vpn, entry->gpu_address, entry->cpu_address, config_.page_size);
+                    perf_counters_.gpu_to_cpu_migrations++;
+                    perf_counters_.total_bytes_migrated += config_.page_size;
+                    perf_counters_.total_migration_time_us += mig_time;
+                }
+
+                entry->resident_on_cpu = true;
+            }
+        }
+    }
+
+    bool VirtualMemoryManager::serve_gpu_fault_remotely(VirtualPageNumber vpn, PageTableEntry *entry)
+    {
+        if (entry->preferred_cpu && entry->resident_on_cpu)
+        {
+            // Map the host copy rather than pull the page off its preferred side.
+            return true;
+        }
+
+        if (thrash_detector_)
+        {
+            uint64_t now_us = get_timestamp_us();
+            if (thrash_detector_->is_remote(vpn, now_us))
+            {
+                return true;
+            }
+
+            ThrashMitigation action = thrash_detector_->on_fault(vpn, now_us);
+            if (action != ThrashMitigation::NONE)
+            {
+                perf_counters_.thrashing_events++;
+            }
+            switch (action)
+            {
+            case ThrashMitigation::PIN:
+                perf_counters_.thrash_pins++;
+                break;
+            case ThrashMitigation::THROTTLE:
+                perf_counters_.thrash_throttles++;
+                pending_throttle_us = thrash_detector_->get_config().throttle_us;
+                break;
+            case ThrashMitigation::REMOTE:
+                perf_counters_.thrash_remote_maps++;
+                return true;
+            default:
+                break;
+            }
+        }
+        return false;
+    }
+
+    void VirtualMemoryManager::run_fault_prefetchers(VirtualPageNumber vpn)
+    {
+        if (stride_prefetcher_)
+        {
+            auto prefetch = stride_prefetcher_->on_access(vpn);
+            issue_prefetch(prefetch.start, prefetch.stride, prefetch.count);
+        }
+        if (tree_prefetcher_)
+        {
+            auto promotion = tree_prefetcher_->on_fault(vpn);
+            issue_prefetch(promotion.start, 1, promotion.num_pages);
+        }
+    }
+
+    void VirtualMemoryManager::service_fault_batch(const std::vector<VirtualPageNumber> &vpns, std::vector<uint64_t> &throttle_us)
+    {
+        std::shared_lock<std::shared_mutex> lock(manager_mutex_);
+
+        if (!initialized_)
+            return;
+
+        // Settle every fault first: refreshes, remote mappings and throttles. Only
+        // the pages left to migrate without a frame need room.
+        std::vector<VirtualPageNumber> migrating;
+        std::vector<VirtualPageNumber> need_frames;
+        std::vector<bool> skip_admission; // preferred_gpu pages, as in acquire_gpu_frame
+        for (size_t first = 0; first < vpns.size();)
+        {
+            size_t last = first + 1;
+            while (last < vpns.size() && vpns[last] == vpns[last - 1] + 1 && last - first < PREFETCH_CHUNK_PAGES)
+            {
+                last++;
+            }
+            std::optional<PageRangeLock> range_lock;
+            lock_settled(range_lock, vpns[first], last - first);
+
+            for (size_t i = first; i < last; i++)
+            {
+                VirtualPageNumber vpn = vpns[i];
+                auto entry = page_table_->lookup_entry(vpn);
+                if (entry && entry->resident_on_gpu)
+                {
+                    refresh_gpu_copy(vpn, entry);
+                }
+                else if (entry && !serve_gpu_fault_remotely(vpn, entry))
+                {
+                    migrating.push_back(vpn);
+                    if (entry->gpu_address == 0)
+                    {
+                        need_frames.push_back(vpn);
+                        skip_admission.push_back(entry->preferred_gpu);
+                    }
+                }
+
+                // Throttling targets the faulting threads; the buffer hands it back to them.
+                throttle_us[i] = pending_throttle_us;
+                pending_throttle_us = 0;
+            }
+            first = last;
+        }
+
+        // Make room for the whole batch at once: one batched writeback instead of
+        // an eviction per fault. Faults take free frames in order; each one past
+        // them faces the admission filter against its victim and stays on the host
+        // copy if rejected.
+        size_t free_frames = allocator_->get_available_gpu_pages();
+        if (need_frames.size() > free_frames)
+        {
+            std::vector<VirtualPageNumber> rejected;
+            std::function<bool(VirtualPageNumber)> admit;
+            if (admission_filter_)
+            {
+                size_t next = free_frames;
+                admit = [&, next](VirtualPageNumber victim) mutable
+                {
+                    size_t index = next++;
+                    if (skip_admission[index] || admission_filter_->admit(need_frames[index], victim))
+                    {
+                        return true;
+                    }
+                    perf_counters_.admission_rejections++;
+                    LOG_TRACE("Admission rejected VPN %lu, keeping VPN %lu resident", need_frames[index], victim);
+                    rejected.push_back(need_frames[index]);
+                    return false;
+                };
+            }
+            perf_counters_.direct_evictions += evict_gpu_pages(need_frames.size() - free_frames, admit);
+            migrating.erase(std::remove_if(migrating.begin(), migrating.end(), [&rejected](VirtualPageNumber vpn)
+                                           { return std::binary_search(rejected.begin(), rejected.end(), vpn); }),
+                            migrating.end());
+        }
+
+        // Runs of consecutive VPNs share their page locks and one coalesced copy.
+        for (size_t first = 0; first < migrating.size();)
+        {
+            size_t last = first + 1;
+            while (last < migrating.size() && migrating[last] == migrating[last - 1] + 1 &&
+                   last - first < PREFETCH_CHUNK_PAGES)
+            {
+                last++;
+            }
+            std::optional<PageRangeLock> range_lock;
+            lock_settled(range_lock, migrating[first], last - first);
+            for (auto vpn : migrate_range_to_gpu(migrating[first], last - first, MigrationPriority::DEMAND))
+            {
+                run_fault_prefetchers(vpn);
+            }
+            first = last;
+        }
+    }
+
+    std::vector<VirtualPageNumber> VirtualMemoryManager::migrate_range_to_gpu(VirtualPageNumber vpn_start, size_t num_pages,
+                                                                             MigrationPriority priority,
+                                                                             std::optional<PageRangeLock> *range_lock)
+    {
+        std::vector<MigrationManager::PageTransfer> transfers;
+        std::vector<VirtualPageNumber> mapped;
+
+        for (VirtualPageNumber vpn = vpn_start; vpn < vpn_start + num_pages; vpn++)
+        {
+            auto entry = page_table_->lookup_entry(vpn);
+            if (!entry || (entry->resident_on_gpu && !entry->cpu_dirty))
+            {
+                continue;
+            }
+            if (entry->gpu_address == 0)
+            {
+                // Admission is decided per page, so a rejected page does not end the run.
+                FrameResult frame = acquire_gpu_frame(vpn, entry, priority == MigrationPriority::DEMAND);
+                if (frame == FrameResult::REJECTED)
+                {
+                    continue;
+                }
+                if (frame == FrameResult::NO_FRAME)
+                {
+                    LOG_DEBUG("GPU full, mapped %zu of %zu pages from VPN %lu", mapped.size(), num_pages, vpn_start);
+                    break;
+                }
+            }
+
+            if (entry->is_zero)
+            {
+                zero_fill_gpu_frame(entry);
+            }
+            else if (entry->resident_on_cpu)
+            {
+                transfers.push_back({vpn, entry->cpu_address, entry->gpu_address});
+            }
+            mapped.push_back(vpn);
+        }
+
+        bool in_transit = range_lock && !transfers.empty();
+        if (!transfers.empty())
+        {
+            auto pending = migration_manager_->submit_batch(transfers, config_.page_size,
+                                                            MigrationDirection::HOST_TO_DEVICE, priority);
+            if (in_transit)
+            {
+                // Only the page table update needs the locks; accesses to these
+                // pages wait in lock_settled until the copy has landed.
+                for (auto vpn : mapped)
+                {
+                    page_table_->lookup_entry(vpn)->in_transit = true;
+                }
+                pages_in_transit_ += mapped.size();
+                range_lock->reset();
+            }
+            auto batch = pending.wait();
+            if (in_transit)
+            {
+                range_lock->emplace(page_locks_, vpn_start, num_pages);
+            }
+
+            perf_counters_.cpu_to_gpu_migrations += batch.pages;
+            perf_counters_.total_bytes_migrated += batch.bytes;
+            perf_counters_.total_migration_time_us += batch.time_us;
+            perf_counters_.migration_batches++;
+            perf_counters_.migration_batch_copies += batch.runs;
+        }
+
+        for (const auto &page : transfers)
+        {
+            auto entry = page_table_->lookup_entry(page.vpn);
+            entry->cpu_dirty = false;
+            entry->cpu_dirty_granules = 0;
+        }
+        for (auto vpn : mapped)
+        {
+            auto entry = page_table_->lookup_entry(vpn);
+            entry->resident_on_gpu = true;
+            entry->in_transit = false;
+        }
+        {
+            std::lock_guard<std::mutex> residency_lock(residency_mutex_);
+            gpu_resident_pages_.insert(mapped.begin(), mapped.end());
+        }
+        for (auto vpn : mapped)
+        {
+            replacement_policy_->on_page_allocated(vpn);
+            if (tree_prefetcher_)
+            {
+                tree_prefetcher_->on_resident(vpn);
+            }
+        }
+        if (in_transit)
+        {
+            end_transit(mapped.size());
+        }
+        return mapped;
+    }
+
+    size_t VirtualMemoryManager::migrate_range_to_cpu(VirtualPageNumber vpn_start, size_t num_pages)
+    {
+        if (!fault_in_host_range(vpn_to_vaddr(vpn_start, config_.page_size), num_pages * config_.page_size, false))
+        {
+            LOG_WARN("Prefetch to CPU of VPN range [%lu, %lu) failed", vpn_start, vpn_start + num_pages);
+            return 0;
+        }
+
+        // The host copies are current now, so unpinned device frames go without a writeback.
+        size_t moved = 0;
+        uint64_t now_us = get_timestamp_us();
+        for (VirtualPageNumber vpn = vpn_start; vpn < vpn_start + num_pages; vpn++)
+        {
+            auto entry = page_table_->lookup_entry(vpn);
+            if (entry->resident_on_gpu && entry->pin_count == 0)
+            {
+                replacement_policy_->on_page_freed(vpn);
+                release_gpu_frame(vpn, entry);
+                if (thrash_detector_)
+                {
+                    thrash_detector_->on_eviction(vpn, now_us);
+                }
+                moved++;
             }
         }
-        else
+        return moved;
+    }
+
+    void VirtualMemoryManager::issue_prefetch(VirtualPageNumber start, int64_t stride, size_t count)
+    {
+        if (count == 0)
+            return;
+
+        default_stream_->enqueue([this, start, stride, count]()
+                                 {
+            std::shared_lock<std::shared_mutex> lock(manager_mutex_);
+            if (!initialized_)
+                return;
+
+            // Contiguous ranges move in coalesced chunks, other strides page by page.
+            // A whole-region promotion would otherwise hold every page lock stripe.
+            size_t group = stride == 1 ? PREFETCH_CHUNK_PAGES : 1;
+            for (size_t done = 0; done < count; done += group)
+            {
+                VirtualPageNumber vpn_start = start + (int64_t)done * stride;
+                size_t pages = std::min(group, count - done);
+                std::optional<PageRangeLock> range_lock;
+                lock_settled(range_lock, vpn_start, pages);
+
+                std::vector<VirtualPageNumber> missing;
+                for (VirtualPageNumber vpn = vpn_start; vpn < vpn_start + pages; vpn++)
+                {
+                    auto entry = page_table_->lookup_entry(vpn);
+                    if (entry && !entry->resident_on_gpu)
+                    {
+                        missing.push_back(vpn);
+                    }
+                }
+                if (missing.empty())
+                    continue;
+
+                auto moved = migrate_range_to_gpu(vpn_start, pages, MigrationPriority::PREFETCH, &range_lock);
+                perf_counters_.page_prefetches += moved.size();
+                for (auto vpn : moved)
+                {
+                    if (std::binary_search(missing.begin(), missing.end(), vpn))
+                    {
+                        page_table_->lookup_entry(vpn)->prefetched = true;
+                    }
+                }
+                if (moved.empty())
+                    break;
+            } });
+    }
+
+    void VirtualMemoryManager::lock_settled(std::optional<PageRangeLock> &range_lock, VirtualPageNumber vpn_start,
+                                            size_t num_pages)
+    {
+        const PageTable &table = *page_table_;
+        while (true)
         {
-            
-            if (!entry->resident_on_cpu)
+            range_lock.emplace(page_locks_, vpn_start, num_pages);
+            if (pages_in_transit_.load(std::memory_order_acquire) == 0)
             {
-                if (entry->cpu_address == nullptr)
+                return;
+            }
+
+            // Read the epoch under the page locks: the transit we wait for can only
+            // end after they are released, so it moves the epoch past this value.
+            uint64_t epoch;
+            {
+                std::lock_guard<std::mutex> transit_lock(transit_mutex_);
+                epoch = transit_epoch_;
+            }
+            bool settled = true;
+            for (VirtualPageNumber vpn = vpn_start; vpn < vpn_start + num_pages && settled; vpn++)
+            {
+                const PageTableEntry *entry = table.get_entry(vpn);
+                settled = !entry || !entry->in_transit;
+            }
+            if (settled)
+            {
+                return;
+            }
+
+            // Attach to the copy already under way rather than start another.
+            range_lock.reset();
+            perf_counters_.in_flight_waits++;
+            std::unique_lock<std::mutex> transit_lock(transit_mutex_);
+            transit_cv_.wait(transit_lock, [this, epoch]()
+                             { return transit_epoch_ != epoch; });
+        }
+    }
+
+    void VirtualMemoryManager::end_transit(size_t num_pages)
+    {
+        pages_in_transit_ -= num_pages;
+        {
+            std::lock_guard<std::mutex> transit_lock(transit_mutex_);
+            transit_epoch_++;
+        }
+        transit_cv_.notify_all();
+    }
+
+    VirtualMemoryManager::FrameResult VirtualMemoryManager::acquire_gpu_frame(VirtualPageNumber vpn, PageTableEntry *entry,
+                                                                              bool demand)
+    {
+        uint64_t gpu_addr = 0;
+        while (gpu_addr == 0)
+        {
+            // Another faulting thread may take the frame we freed; evict again.
+            if (allocator_->get_available_gpu_pages() == 0)
+            {
+                PageLock victim_lock;
+                VirtualPageNumber victim = select_gpu_victim(victim_lock);
+                if (victim == 0)
                 {
-                    entry->cpu_address = allocator_->allocate_cpu_page();
+                    LOG_WARN("No GPU frame available for VPN %lu", vpn);
+                    return FrameResult::NO_FRAME;
                 }
 
-                if (entry->resident_on_gpu)
+                
+                if (demand && admission_filter_ && !entry->preferred_gpu && !admission_filter_->admit(vpn, victim))
                 {
-                    uint64_t mig_time = migration_manager_->migrate_gpu_to_cpu(
-                        vpn, entry->gpu_address, entry->cpu_address, config_.page_size);
-                    perf_counters_.gpu_to_cpu_migrations++;
-                    perf_counters_.total_bytes_migrated += config_.page_size;
-                    perf_counters_.total_migration_time_us += mig_time;
+                    replacement_policy_->on_victim_declined(victim);
+                    perf_counters_.admission_rejections++;
+                    LOG_TRACE("Admission rejected VPN %lu, keeping VPN %lu resident", vpn, victim);
+                    return FrameResult::REJECTED;
                 }
 
-                entry->resident_on_cpu = true;
+                evict_page_from_gpu(victim);
+                perf_counters_.direct_evictions++;
             }
+
+            gpu_addr = allocator_->allocate_gpu_page();
+        }
+        entry->gpu_address = gpu_addr;
+
+        if (eviction_daemon_ && eviction_daemon_->below_low_watermark())
+        {
+            eviction_daemon_->wake();
         }
+        return FrameResult::ACQUIRED;
     }
 
-    void VirtualMemoryManager::evict_page_from_gpu()
+    VirtualPageNumber VirtualMemoryManager::select_gpu_victim(PageLock &victim_lock)
     {
-        if (gpu_resident_pages_.empty())
-            return;
+        if (access_batcher_)
+        {
+            access_batcher_->drain_all();
+        }
+
+        std::lock_guard<std::mutex> residency_lock(residency_mutex_);
+        uint64_t now_us = get_timestamp_us();
+        std::vector<VirtualPageNumber> skipped;
+        std::vector<VirtualPageNumber> deferred;
+        std::vector<PageLock> deferred_locks;
+        VirtualPageNumber chosen = 0;
+        // A page whose lock is busy is being written or faulted on: count it as dirty.
+        auto is_clean = [this](VirtualPageNumber vpn)
+        {
+            PageLock lock(page_locks_, vpn);
+            if (!lock.locked())
+            {
+                return false;
+            }
+            auto entry = page_table_->lookup_entry(vpn);
+            return !entry || !entry->gpu_dirty;
+        };
+
+        
+        while (true)
+        {
+            VirtualPageNumber victim = config_.prefer_clean_victims
+                                           ? replacement_policy_->select_clean_victim(is_clean, config_.clean_victim_window)
+                                           : replacement_policy_->select_victim();
+            if (victim == 0)
+            {
+                break;
+            }
+            if (!gpu_resident_pages_.count(victim))
+            {
+                continue;
+            }
+            // A page another thread is faulting on or accessing is not a victim.
+            PageLock lock(page_locks_, victim);
+            if (!lock.locked() || !is_evictable(victim, now_us))
+            {
+                skipped.push_back(victim);
+                continue;
+            }
+            if (page_table_->lookup_entry(victim)->preferred_gpu)
+            {
+                deferred.push_back(victim);
+                deferred_locks.push_back(std::move(lock));
+                continue;
+            }
+            chosen = victim;
+            victim_lock = std::move(lock);
+            break;
+        }
 
-        VirtualPageNumber victim = replacement_policy_->select_victim();
-        if (victim == 0 && gpu_resident_pages_.size() > 0)
+        // Pages that prefer the GPU go only when nothing else can.
+        if (chosen == 0 && !deferred.empty())
         {
-            victim = *gpu_resident_pages_.begin();
+            chosen = deferred.front();
+            victim_lock = std::move(deferred_locks.front());
+            deferred.erase(deferred.begin());
         }
 
-        if (victim == 0)
-            return;
+        // Hand passed-over pages back as the next candidates, newest first so the
+        // oldest ends up in front again.
+        for (auto it = skipped.rbegin(); it != skipped.rend(); ++it)
+        {
+            replacement_policy_->on_victim_declined(*it);
+        }
+        for (auto it = deferred.rbegin(); it != deferred.rend(); ++it)
+        {
+            replacement_policy_->on_victim_declined(*it);
+        }
+
+        if (chosen == 0 && skipped.empty())
+        {
+            for (auto vpn : gpu_resident_pages_)
+            {
+                PageLock lock(page_locks_, vpn);
+                if (lock.locked() && is_evictable(vpn, now_us))
+                {
+                    chosen = vpn;
+                    victim_lock = std::move(lock);
+                    break;
+                }
+            }
+        }
+        return chosen;
+    }
+
+    bool VirtualMemoryManager::is_evictable(VirtualPageNumber vpn, uint64_t now_us) const
+    {
+        auto entry = page_table_->lookup_entry(vpn);
+        if (entry && (entry->pin_count > 0 || entry->in_transit))
+        {
+            return false;
+        }
+        return !(thrash_detector_ && thrash_detector_->is_pinned(vpn, now_us));
+    }
 
+    void VirtualMemoryManager::evict_page_from_gpu(VirtualPageNumber victim)
+    {
         auto entry = page_table_->lookup_entry(victim);
         if (entry)
         {
-            if (entry->is_dirty && entry->resident_on_cpu)
+            if (!entry->gpu_dirty)
             {
-                
-                uint64_t mig_time = migration_manager_->migrate_gpu_to_cpu(
-                    victim, entry->gpu_address, entry->cpu_address, config_.page_size);
-                perf_counters_.gpu_to_cpu_migrations++;
-                perf_counters_.total_bytes_migrated += config_.page_size;
-                perf_counters_.total_migration_time_us += mig_time;
+                perf_counters_.clean_evictions++;
+            }
+            writeback_page(victim, entry);
+            release_gpu_frame(victim, entry);
+            perf_counters_.evictions++;
+            if (thrash_detector_)
+            {
+                thrash_detector_->on_eviction(victim, get_timestamp_us());
             }
+        }
+    }
+
+    size_t VirtualMemoryManager::reclaim_gpu_frames(size_t max_pages)
+    {
+        std::shared_lock<std::shared_mutex> lock(manager_mutex_);
+
+        if (!initialized_)
+            return 0;
+
+        size_t evicted = evict_gpu_pages(max_pages);
+        perf_counters_.background_evictions += evicted;
+        LOG_TRACE("Background reclaim evicted %zu pages", evicted);
+        return evicted;
+    }
 
-            allocator_->deallocate_gpu_page(entry->gpu_address);
-            entry->gpu_address = 0;
-            entry->resident_on_gpu = false;
+    size_t VirtualMemoryManager::evict_gpu_pages(size_t max_pages, const std::function<bool(VirtualPageNumber)> &admit)
+    {
+        std::vector<VirtualPageNumber> victims;
+        std::vector<PageLock> victim_locks;
+        std::vector<MigrationManager::PageTransfer> writebacks;
+        for (size_t attempt = 0; attempt < max_pages; attempt++)
+        {
+            PageLock victim_lock;
+            VirtualPageNumber victim = select_gpu_victim(victim_lock);
+            if (victim == 0)
+            {
+                break;
+            }
+            if (admit && !admit(victim))
+            {
+                replacement_policy_->on_victim_declined(victim);
+                continue;
+            }
+            victim_locks.push_back(std::move(victim_lock));
+            auto entry = page_table_->lookup_entry(victim);
+            if (entry->gpu_dirty && (entry->gpu_dirty_granules || entry->is_zero))
+            {
+                writeback_page(victim, entry);
+            }
+            else if (entry->gpu_dirty && entry->resident_on_cpu)
+            {
+                writebacks.push_back({victim, entry->cpu_address, entry->gpu_address});
+            }
+            else
+            {
+                perf_counters_.clean_evictions++;
+            }
+            victims.push_back(victim);
+            // Hide it from select_gpu_victim's fallback scan until the frame is released;
+            // this thread already holds its page lock, so the scan would accept it again.
+            std::lock_guard<std::mutex> residency_lock(residency_mutex_);
             gpu_resident_pages_.erase(victim);
+        }
+
+        // Dirty victims stay mapped and in transit while their writeback runs, so
+        // their locks go now with everyone else's.
+        MigrationManager::PendingBatch pending;
+        if (!writebacks.empty())
+        {
+            for (const auto &page : writebacks)
+            {
+                page_table_->lookup_entry(page.vpn)->in_transit = true;
+            }
+            pages_in_transit_ += writebacks.size();
+            pending = migration_manager_->submit_batch(writebacks, config_.page_size,
+                                                       MigrationDirection::DEVICE_TO_HOST, MigrationPriority::WRITEBACK);
+        }
+
+        uint64_t now_us = get_timestamp_us();
+        auto evicted = [this, now_us](VirtualPageNumber vpn, PageTableEntry *entry)
+        {
+            release_gpu_frame(vpn, entry);
             perf_counters_.evictions++;
-            tlb_->invalidate(victim);
+            if (thrash_detector_)
+            {
+                thrash_detector_->on_eviction(vpn, now_us);
+            }
+        };
+        for (auto vpn : victims)
+        {
+            auto entry = page_table_->lookup_entry(vpn);
+            if (!entry->in_transit)
+            {
+                evicted(vpn, entry);
+            }
+        }
+        victim_locks.clear();
+
+        if (!writebacks.empty())
+        {
+            auto batch = pending.wait();
+            perf_counters_.gpu_to_cpu_migrations += batch.pages;
+            perf_counters_.total_bytes_migrated += batch.bytes;
+            perf_counters_.total_migration_time_us += batch.time_us;
+            perf_counters_.migration_batches++;
+            perf_counters_.migration_batch_copies += batch.runs;
+
+            for (const auto &page : writebacks)
+            {
+                PageRangeLock page_lock(page_locks_, page.vpn, 1);
+                auto entry = page_table_->lookup_entry(page.vpn);
+                entry->in_transit = false;
+                evicted(page.vpn, entry);
+            }
+            end_transit(writebacks.size());
+        }
+        return victims.size();
+    }
+
+    void VirtualMemoryManager::writeback_page(VirtualPageNumber vpn, PageTableEntry *entry)
+    {
+        if (!entry->gpu_dirty || !entry->resident_on_gpu)
+        {
+            return;
+        }
+
+        if (entry->is_zero)
+        {
+            // A device copy that is still all zeros needs no host frame.
+            uint8_t *gpu_ptr = allocator_->gpu_page_ptr(entry->gpu_address);
+            if (gpu_ptr && is_all_zero(gpu_ptr, config_.page_size))
+            {
+                entry->gpu_dirty = false;
+                entry->gpu_dirty_granules = 0;
+                perf_counters_.zero_page_elisions++;
+                return;
+            }
+            if (!materialize_cpu_page(entry))
+            {
+                LOG_ERROR("No CPU frame to write back VPN %lu", vpn);
+                return;
+            }
+            entry->resident_on_cpu = true;
+        }
+
+        if (!entry->resident_on_cpu)
+        {
+            return;
+        }
+
+        if (entry->gpu_dirty_granules)
+        {
+            record_delta(migration_manager_->migrate_granules({vpn, entry->cpu_address, entry->gpu_address},
+                                                              config_.dirty_granule_size, entry->gpu_dirty_granules,
+                                                              MigrationDirection::DEVICE_TO_HOST),
+                         false);
+            return;
+        }
+
+        uint64_t mig_time = migration_manager_->migrate_gpu_to_cpu(
+            vpn, entry->gpu_address, entry->cpu_address, config_.page_size);
+        perf_counters_.gpu_to_cpu_migrations++;
+        perf_counters_.total_bytes_migrated += config_.page_size;
+        perf_counters_.total_migration_time_us += mig_time;
+        entry->gpu_dirty = false;
+    }
+
+    void VirtualMemoryManager::refresh_gpu_copy(VirtualPageNumber vpn, PageTableEntry *entry)
+    {
+        if (!entry->cpu_dirty || !entry->resident_on_gpu || !entry->resident_on_cpu)
+        {
+            return;
+        }
+
+        if (entry->cpu_dirty_granules)
+        {
+            record_delta(migration_manager_->migrate_granules({vpn, entry->cpu_address, entry->gpu_address},
+                                                              config_.dirty_granule_size, entry->cpu_dirty_granules,
+                                                              MigrationDirection::HOST_TO_DEVICE),
+                         true);
+            return;
+        }
+
+        uint64_t mig_time = migration_manager_->migrate_cpu_to_gpu(
+            vpn, entry->cpu_address, entry->gpu_address, config_.page_size);
+        perf_counters_.cpu_to_gpu_migrations++;
+        perf_counters_.total_bytes_migrated += config_.page_size;
+        perf_counters_.total_migration_time_us += mig_time;
+        entry->cpu_dirty = false;
+    }
+
+    void VirtualMemoryManager::map_zero_page(PageTableEntry *entry)
+    {
+        entry->cpu_address = allocator_->get_zero_page();
+        entry->resident_on_cpu = true;
+    }
+
+    bool VirtualMemoryManager::materialize_cpu_page(PageTableEntry *entry)
+    {
+        void *cpu_page = allocator_->allocate_cpu_page();
+        if (!cpu_page)
+        {
+            return false;
+        }
+        std::memset(cpu_page, 0, config_.page_size);
+        entry->cpu_address = cpu_page;
+        entry->is_zero = false;
+        return true;
+    }
+
+    void VirtualMemoryManager::zero_fill_gpu_frame(PageTableEntry *entry)
+    {
+        uint8_t *gpu_ptr = allocator_->gpu_page_ptr(entry->gpu_address);
+        if (gpu_ptr)
+        {
+            std::memset(gpu_ptr, 0, config_.page_size);
+        }
+        perf_counters_.zero_page_fills++;
+    }
+
+    uint64_t VirtualMemoryManager::dirty_granules(size_t offset, size_t bytes) const
+    {
+        if (!config_.dirty_granule_size || bytes == 0)
+        {
+            return 0;
+        }
+        size_t first = offset / config_.dirty_granule_size;
+        size_t last = std::min(offset + bytes - 1, config_.page_size - 1) / config_.dirty_granule_size;
+        uint64_t upto_last = last >= 63 ? ~0ULL : (1ULL << (last + 1)) - 1;
+        return upto_last & ~((1ULL << first) - 1);
+    }
+
+    void VirtualMemoryManager::record_delta(const MigrationManager::BatchResult &delta, bool h2d)
+    {
+        (h2d ? perf_counters_.cpu_to_gpu_migrations : perf_counters_.gpu_to_cpu_migrations)++;
+        perf_counters_.total_bytes_migrated += delta.bytes;
+        perf_counters_.total_migration_time_us += delta.time_us;
+        perf_counters_.delta_migrations++;
+        perf_counters_.delta_bytes_saved += config_.page_size - delta.bytes;
+    }
+
+    void VirtualMemoryManager::release_gpu_frame(VirtualPageNumber vpn, PageTableEntry *entry)
+    {
+        allocator_->deallocate_gpu_page(entry->gpu_address);
+        entry->gpu_address = 0;
+        entry->resident_on_gpu = false;
+        if (entry->prefetched && stride_prefetcher_)
+        {
+            stride_prefetcher_->on_wasted();
+        }
+        entry->prefetched = false;
+        if (tree_prefetcher_)
+        {
+            tree_prefetcher_->on_evicted(vpn);
+        }
+        entry->cpu_dirty = false;
+        entry->gpu_dirty = false;
+        entry->cpu_dirty_granules = 0;
+        entry->gpu_dirty_granules = 0;
+        {
+            std::lock_guard<std::mutex> residency_lock(residency_mutex_);
+            gpu_resident_pages_.erase(vpn);
         }
+        tlb_->invalidate(vpn);
     }
 
     VirtualPageNumber VirtualMemoryManager::get_next_vpn()
     {
+        std::lock_guard<std::mutex> alloc_lock(alloc_mutex_);
         return next_vpn_++;
     }
 
     size_t VirtualMemoryManager::get_gpu_pages_used() const
     {
         std::shared_lock<std::shared_mutex> lock(manager_mutex_);
+        std::lock_guard<std::mutex> residency_lock(residency_mutex_);
         return gpu_resident_pages_.size();
     }
 
@@ -529,6 +1934,14 @@ namespace uvm_sim
         return allocator_->get_available_gpu_pages();
     }
 
+    size_t VirtualMemoryManager::get_gpu_pages_pinned() const
+    {
+        std::shared_lock<std::shared_mutex> lock(manager_mutex_);
+        if (!allocator_)
+            return 0;
+        return allocator_->get_pinned_gpu_pages();
+    }
+
     size_t VirtualMemoryManager::get_cpu_pages_used() const
     {
         std::shared_lock<std::shared_mutex> lock(manager_mutex_);
@@ -537,6 +1950,18 @@ namespace uvm_sim
         return page_table_->get_num_allocated_pages();
     }
 
+    std::vector<TraceAccess> VirtualMemoryManager::get_access_trace() const
+    {
+        std::lock_guard<std::mutex> trace_lock(trace_mutex_);
+        return access_trace_;
+    }
+
+    void VirtualMemoryManager::clear_access_trace()
+    {
+        std::lock_guard<std::mutex> trace_lock(trace_mutex_);
+        access_trace_.clear();
+    }
+
     void VirtualMemoryManager::print_stats() const
     {
         std::shared_lock<std::shared_mutex> lock(manager_mutex_);
@@ -552,8 +1977,81 @@ namespace uvm_sim
                       << (tlb_->get_hit_rate() * 100.0) << std::endl;
         }
 
+        if (access_batcher_)
+        {
+            std::cout << "\n=== Policy Access Batching ===" << std::endl;
+            std::cout << "Accesses Recorded: " << access_batcher_->get_recorded() << std::endl;
+            std::cout << "Batches Drained:   " << access_batcher_->get_batches() << std::endl;
+        }
+
+        if (eviction_daemon_)
+        {
+            std::cout << "\n=== Background Eviction ===" << std::endl;
+            std::cout << "Watermarks (free frames): " << eviction_daemon_->get_low_watermark_pages() << " / "
+                      << eviction_daemon_->get_high_watermark_pages() << std::endl;
+            std::cout << "Daemon Wakeups:    " << eviction_daemon_->get_wakeups() << std::endl;
+            std::cout << "Pages Reclaimed:   " << eviction_daemon_->get_pages_reclaimed() << std::endl;
+        }
+
+        if (fault_buffer_)
+        {
+            std::cout << "\n=== Fault Buffer ===" << std::endl;
+            std::cout << "Faults Buffered:   " << fault_buffer_->get_faults() << std::endl;
+            std::cout << "Batches Serviced:  " << fault_buffer_->get_batches() << " (largest "
+                      << fault_buffer_->get_max_batch() << ")" << std::endl;
+            std::cout << "Duplicate Faults:  " << fault_buffer_->get_duplicates() << std::endl;
+        }
+
+        if (stride_prefetcher_)
+        {
+            std::cout << "\n=== Stride Prefetcher ===" << std::endl;
+            std::cout << "Pages Issued:      " << stride_prefetcher_->get_issued() << std::endl;
+            std::cout << "Used Before Evict: " << stride_prefetcher_->get_useful() << std::endl;
+            std::cout << "Evicted Unused:    " << stride_prefetcher_->get_wasted() << std::endl;
+            std::cout << "Accuracy (%):      " << std::fixed << std::setprecision(2)
+                      << (stride_prefetcher_->get_accuracy() * 100.0) << " (depth cap "
+                      << stride_prefetcher_->get_depth_cap() << ")" << std::endl;
+        }
+
+        if (tree_prefetcher_)
+        {
+            std::cout << "\n=== Tree Prefetcher (" << tree_prefetcher_->get_region_pages() << "-page regions) ===" << std::endl;
+            for (uint32_t level = 1; level < tree_prefetcher_->get_num_levels(); level++)
+            {
+                std::cout << "Level " << level << " (" << ((size_t)1 << level) << " pages) Promotions: "
+                          << tree_prefetcher_->get_promotions(level) << std::endl;
+            }
+            std::cout << "Pages Promoted:    " << tree_prefetcher_->get_pages_promoted() << std::endl;
+        }
+
+        if (migration_manager_)
+        {
+            const auto h2d = MigrationDirection::HOST_TO_DEVICE;
+            const auto d2h = MigrationDirection::DEVICE_TO_HOST;
+            std::cout << "\n=== Link Model (" << migration_manager_->get_link().name << ") ===" << std::endl;
+            std::cout << "H2D Transfers:     " << migration_manager_->get_transfers(h2d) << " ("
+                      << migration_manager_->get_bytes_transferred(h2d) << " bytes, "
+                      << migration_manager_->get_modeled_bandwidth_gbps(h2d) << " GB/s, compression "
+                      << migration_manager_->get_compression_ratio(h2d) << "x)" << std::endl;
+            std::cout << "D2H Transfers:     " << migration_manager_->get_transfers(d2h) << " ("
+                      << migration_manager_->get_bytes_transferred(d2h) << " bytes, "
+                      << migration_manager_->get_modeled_bandwidth_gbps(d2h) << " GB/s, compression "
+                      << migration_manager_->get_compression_ratio(d2h) << "x)" << std::endl;
+            for (auto dir : {h2d, d2h})
+            {
+                for (const auto &engine : migration_manager_->get_copy_engines(dir))
+                {
+                    std::cout << (dir == h2d ? "H2D" : "D2H") << " Copy Engine " << engine->get_id() << ": "
+                              << engine->get_jobs_completed() << " jobs, "
+                              << (engine->get_utilization() * 100.0) << "% busy, max depth "
+                              << engine->get_max_queue_depth() << std::endl;
+                }
+            }
+        }
+
         if (allocator_)
         {
+            std::lock_guard<std::mutex> residency_lock(residency_mutex_);
             std::cout << "\n=== Memory Usage ===" << std::endl;
             std::cout << "GPU Pages Used:    " << gpu_resident_pages_.size() << std::endl;
             std::cout << "GPU Pages Available: " << allocator_->get_available_gpu_pages() << std::endl;
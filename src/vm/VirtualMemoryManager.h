@@ -6,7 +6,18 @@
 #include "TLB.h"
 #include "MigrationManager.h"
 #include "Policies.h"
+#include "FrequencySketch.h"
+#include "TraceSimulator.h"
+#include "AccessBatcher.h"
+#include "ThrashDetector.h"
+#include "EvictionDaemon.h"
+#include "FaultBuffer.h"
+#include "StridePrefetcher.h"
+#include "TreePrefetcher.h"
+#include "PageLocks.h"
+#include "Stream.h"
 #include <memory>
+#include <optional>
 #include <thread>
 
 namespace uvm_sim
@@ -21,12 +32,37 @@ namespace uvm_sim
         size_t page_size = DEFAULT_PAGE_SIZE;
         size_t virtual_address_space = DEFAULT_VIRTUAL_ADDRESS_SPACE;
         size_t gpu_memory = DEFAULT_GPU_MEMORY;
+        size_t cpu_memory = 0; // host page pool; 0 sizes it like gpu_memory
         size_t tlb_size = DEFAULT_TLB_SIZE;
         size_t tlb_associativity = DEFAULT_TLB_ASSOCIATIVITY;
         PageReplacementPolicy replacement_policy = PageReplacementPolicy::LRU;
         bool use_pinned_memory = true;
         bool use_gpu_simulator = false;
-        bool enable_prefetch = true;
+        bool eager_population = false;    // back every page with a CPU frame in allocate
+        bool zero_fill_on_demand = false; // host reads of untouched pages map a shared zero frame
+        bool enable_prefetch = false; // migrate ahead of sequential and strided GPU fault streams
+        StridePrefetcher::Config prefetch;
+        bool enable_tree_prefetch = false; // migrate dense subtrees of a region along with a GPU fault
+        TreePrefetcher::Config tree_prefetch;
+        bool enable_admission_filter = false;
+        bool record_access_trace = false;
+        size_t policy_access_batch = 16; // 0 reports every access to the policy directly
+        bool enable_thrash_detection = false;
+        ThrashDetector::Config thrash_detection;
+        double max_pinned_gpu_fraction = 0.5;
+        LinkModel link = LinkModel::pcie_gen4_x16();
+        bool emulate_link_timing = false; // spin for the modeled transfer time on every migration
+        LinkCompression link_compression = LinkCompression::NONE;
+        size_t streaming_copy_threshold = 1 << 20; // read/write_to_vaddr copies this large bypass the cache; 0 never
+        size_t h2d_copy_engines = 2;
+        size_t d2h_copy_engines = 2;
+        size_t dirty_granule_size = 0;     // sub-page dirty tracking for delta copies; 0 tracks whole pages
+        bool prefer_clean_victims = false; // evict pages that need no writeback ahead of dirty ones
+        size_t clean_victim_window = 8;    // coldest candidates considered when preferring clean victims
+        bool enable_background_eviction = false; // reclaim GPU frames ahead of demand between watermarks
+        EvictionDaemon::Config background_eviction;
+        bool enable_fault_buffer = false; // service GPU faults in batches on a servicing thread
+        FaultBuffer::Config fault_buffer;
         LogLevel log_level = LogLevel::INFO;
     };
 
@@ -66,11 +102,31 @@ namespace uvm_sim
 
         
         void prefetch_to_gpu(void *vaddr);
+        void prefetch_to_gpu(void *vaddr, size_t bytes);
+
+        // Queues a coalesced migration of [base, base + bytes) to dst on `stream`
+        // (the manager's default stream if null) and returns at once, like
+        // cudaMemPrefetchAsync. The event completes once the range has moved.
+        Event prefetch_range(void *base, size_t bytes, Location dst, Stream *stream = nullptr);
+
+        // Usage hints for a range, modeled on cudaMemAdvise. `location` selects the
+        // processor for PREFERRED_LOCATION and ACCESSED_BY. The host always keeps
+        // its mapping here, so ACCESSED_BY with Location::CPU has no effect.
+        void advise(void *base, size_t bytes, Advice advice, Location location = Location::GPU);
+
+        // Waits for a copy in flight on the page and reads it under its page lock.
+        PageResidency get_residency(void *vaddr);
 
         
+        bool pin(void *vaddr, size_t bytes);
+        void unpin(void *vaddr, size_t bytes);
+
+        // Hits take the manager lock shared and the page's lock stripe: the PTE
+        // updates must not race an eviction releasing the frame.
         void touch_page(void *vaddr, bool is_write = false);
 
-        
+        // Host copies may span any number of pages; missing pages are faulted
+        // in as one batch before copying.
         void read_from_vaddr(void *vaddr, void *buffer, size_t bytes);
 
         
@@ -90,12 +146,17 @@ namespace uvm_sim
         PerfCounters &get_perf_counters() { return perf_counters_; }
 
         void print_stats() const;
+
+        
+        std::vector<TraceAccess> get_access_trace() const;
+        void clear_access_trace();
         void reset_counters() { perf_counters_.reset(); }
 
         
         size_t get_gpu_pages_used() const;
         size_t get_gpu_pages_available() const;
         size_t get_cpu_pages_used() const;
+        size_t get_gpu_pages_pinned() const;
 
         
         
@@ -104,6 +165,15 @@ namespace uvm_sim
         PageTable *get_page_table() { return page_table_.get(); }
         PageAllocator *get_allocator() { return allocator_.get(); }
         TLB *get_tlb() { return tlb_.get(); }
+        MigrationManager *get_migration_manager() { return migration_manager_.get(); }
+        TinyLFUAdmissionFilter *get_admission_filter() { return admission_filter_.get(); }
+        AccessBatcher *get_access_batcher() { return access_batcher_.get(); }
+        ThrashDetector *get_thrash_detector() { return thrash_detector_.get(); }
+        EvictionDaemon *get_eviction_daemon() { return eviction_daemon_.get(); }
+        FaultBuffer *get_fault_buffer() { return fault_buffer_.get(); }
+        StridePrefetcher *get_stride_prefetcher() { return stride_prefetcher_.get(); }
+        TreePrefetcher *get_tree_prefetcher() { return tree_prefetcher_.get(); }
+        Stream *get_default_stream() { return default_stream_.get(); }
 
     private:
         VirtualMemoryManager() : initialized_(false) {}
@@ -118,10 +188,82 @@ namespace uvm_sim
         
 
         
-        void resolve_page_fault(VirtualPageNumber vpn, bool access_gpu);
+        void resolve_page_fault(VirtualPageNumber vpn, bool access_gpu, bool demand = true);
+
+        // Decides whether a GPU demand fault is left on the host copy (preferred
+        // location, thrash mitigation) instead of migrating.
+        bool serve_gpu_fault_remotely(VirtualPageNumber vpn, PageTableEntry *entry);
+        void run_fault_prefetchers(VirtualPageNumber vpn);
+
+        // Fault buffer callback: vpns is sorted and deduplicated.
+        void service_fault_batch(const std::vector<VirtualPageNumber> &vpns, std::vector<uint64_t> &throttle_us);
+
+        // Maps [vpn_start, vpn_start + num_pages) on the GPU and returns the pages
+        // it mapped. With range_lock (the caller's lock on that range) the copy
+        // runs with the lock dropped and the pages marked in transit; the lock is
+        // held again on return.
+        std::vector<VirtualPageNumber> migrate_range_to_gpu(VirtualPageNumber vpn_start, size_t num_pages,
+                                                            MigrationPriority priority,
+                                                            std::optional<PageRangeLock> *range_lock = nullptr);
+        size_t migrate_range_to_cpu(VirtualPageNumber vpn_start, size_t num_pages);
+
+        // Queues migration of start, start + stride, ... (count pages) to the GPU
+        // on the default stream; used by the fault path prefetchers.
+        void issue_prefetch(VirtualPageNumber start, int64_t stride, size_t count);
+
+        // Makes every page in [addr, addr + bytes) current on the host. Pages a
+        // write fully covers get a frame without fetching the device copy.
+        bool fault_in_host_range(Address addr, size_t bytes, bool is_write);
+
+        // Locks [vpn_start, vpn_start + num_pages) once none of its pages is in
+        // transit. The caller must hold no other page locks.
+        void lock_settled(std::optional<PageRangeLock> &range_lock, VirtualPageNumber vpn_start, size_t num_pages);
+        void end_transit(size_t num_pages);
+
+        // REJECTED means the admission filter kept the victim, which is decided
+        // per page; NO_FRAME means there was nothing to evict.
+        enum class FrameResult
+        {
+            ACQUIRED,
+            REJECTED,
+            NO_FRAME
+        };
+        FrameResult acquire_gpu_frame(VirtualPageNumber vpn, PageTableEntry *entry, bool demand);
 
         
-        void evict_page_from_gpu();
+        // Returns the victim with victim_lock holding its page lock, or 0.
+        VirtualPageNumber select_gpu_victim(PageLock &victim_lock);
+
+        
+        bool is_evictable(VirtualPageNumber vpn, uint64_t now_us) const;
+
+        
+        bool pin_page(VirtualPageNumber vpn);
+        void unpin_page(VirtualPageNumber vpn);
+
+        
+        void evict_page_from_gpu(VirtualPageNumber victim);
+
+        
+        size_t reclaim_gpu_frames(size_t max_pages);
+        // Writes dirty victims back at WRITEBACK priority with their locks dropped.
+        // `admit`, when set, is asked before each of the max_pages evictions and
+        // may keep the victim. The caller must hold no page locks.
+        size_t evict_gpu_pages(size_t max_pages, const std::function<bool(VirtualPageNumber)> &admit = nullptr);
+
+        
+        void writeback_page(VirtualPageNumber vpn, PageTableEntry *entry);
+        void refresh_gpu_copy(VirtualPageNumber vpn, PageTableEntry *entry);
+
+        
+        void map_zero_page(PageTableEntry *entry);
+        bool materialize_cpu_page(PageTableEntry *entry);
+        void zero_fill_gpu_frame(PageTableEntry *entry);
+
+        
+        uint64_t dirty_granules(size_t offset, size_t bytes) const;
+        void record_delta(const MigrationManager::BatchResult &delta, bool h2d);
+        void release_gpu_frame(VirtualPageNumber vpn, PageTableEntry *entry);
 
         
         VirtualPageNumber get_next_vpn();
@@ -143,15 +285,45 @@ namespace uvm_sim
         std::unique_ptr<TLB> tlb_;
         std::unique_ptr<MigrationManager> migration_manager_;
         std::unique_ptr<ReplacementPolicy> replacement_policy_;
+        std::unique_ptr<TinyLFUAdmissionFilter> admission_filter_;
+        std::unique_ptr<AccessBatcher> access_batcher_;
+        std::unique_ptr<ThrashDetector> thrash_detector_;
+        std::unique_ptr<EvictionDaemon> eviction_daemon_;
+        std::shared_ptr<FaultBuffer> fault_buffer_; // shared with accesses stalled in it
+        std::unique_ptr<StridePrefetcher> stride_prefetcher_;
+        std::unique_ptr<TreePrefetcher> tree_prefetcher_;
+        std::unique_ptr<Stream> default_stream_;
+        std::vector<Event> stream_prefetches_; // prefetch_range work queued on caller streams
+        std::mutex stream_prefetches_mutex_;
+
+        struct Allocation
+        {
+            VirtualPageNumber vpn_start;
+            uint32_t num_pages;
+        };
 
         
         VirtualPageNumber next_vpn_;
-        std::unordered_map<Address, VirtualPageNumber> vaddr_to_vpn_map_;
+        std::unordered_map<Address, Allocation> vaddr_to_vpn_map_;
         std::unordered_set<VirtualPageNumber> gpu_resident_pages_;
+        std::vector<TraceAccess> access_trace_;
 
-        
+        // Lock order: manager_mutex_ (shared except initialize/shutdown), then page
+        // locks, then residency_mutex_. Victim page locks are only try-locked, so
+        // holding residency_mutex_ never waits on a page.
         mutable std::shared_mutex manager_mutex_;
-        std::mutex alloc_mutex_;
+        std::mutex alloc_mutex_;              // next_vpn_, vaddr_to_vpn_map_
+        mutable std::mutex residency_mutex_;  // gpu_resident_pages_, victim selection
+        mutable std::mutex trace_mutex_;      // access_trace_
+        PageLockTable page_locks_;
+
+        // Pages with in_transit set. lock_settled waits on transit_cv_ for
+        // transit_epoch_ (under transit_mutex_, taken last) to move, which every
+        // end of a transit does.
+        std::atomic<size_t> pages_in_transit_{0};
+        uint64_t transit_epoch_ = 0;
+        std::mutex transit_mutex_;
+        std::condition_variable transit_cv_;
     };
 
     
@@ -6,6 +6,16 @@
 #include "../src/vm/PageAllocator.h"
 #include "../src/vm/TLB.h"
 #include "../src/vm/Policies.h"
+#include "../src/vm/FrequencySketch.h"
+#include "../src/vm/TraceSimulator.h"
+#include "../src/vm/AccessBatcher.h"
+#include "../src/vm/ThrashDetector.h"
+#include "../src/vm/StridePrefetcher.h"
+#include "../src/vm/TreePrefetcher.h"
+#include "../src/vm/MigrationManager.h"
+#include "../src/vm/MPMCQueue.h"
+#include "../src/vm/Stream.h"
+#include "../src/vm/FaultBuffer.h"
 #include <cstring>
 #include <vector>
 
@@ -58,13 +68,19 @@ TEST_F(PageTableTest, DirtyBit)
     pt->allocate_vpn_range(vpn, 1);
 
     auto entry = pt->lookup_entry(vpn);
-    EXPECT_FALSE(entry->is_dirty);
+    EXPECT_FALSE(entry->cpu_dirty);
+    EXPECT_FALSE(entry->gpu_dirty);
 
-    pt->mark_dirty(vpn);
-    EXPECT_TRUE(entry->is_dirty);
+    pt->mark_dirty(vpn, true);
+    EXPECT_FALSE(entry->cpu_dirty);
+    EXPECT_TRUE(entry->gpu_dirty);
+
+    pt->mark_dirty(vpn, false);
+    EXPECT_TRUE(entry->cpu_dirty);
 
     pt->clear_dirty(vpn);
-    EXPECT_FALSE(entry->is_dirty);
+    EXPECT_FALSE(entry->cpu_dirty);
+    EXPECT_FALSE(entry->gpu_dirty);
 }
 
 TEST_F(PageTableTest, MultiplePages)
@@ -82,6 +98,69 @@ TEST_F(PageTableTest, MultiplePages)
     }
 }
 
+TEST_F(PageTableTest, PinCount)
+{
+    VirtualPageNumber vpn = 500;
+    pt->allocate_vpn_range(vpn, 1);
+
+    EXPECT_EQ(pt->pin(vpn), 1u);
+    EXPECT_EQ(pt->pin(vpn), 2u);
+    EXPECT_TRUE(pt->lookup_entry(vpn)->is_pinned);
+    EXPECT_EQ(pt->unpin(vpn), 1u);
+    EXPECT_EQ(pt->unpin(vpn), 0u);
+    EXPECT_FALSE(pt->lookup_entry(vpn)->is_pinned);
+}
+
+TEST_F(PageTableTest, PopulatedLookupsSurviveConcurrentUpdates)
+{
+    const VirtualPageNumber hot = 100;
+    const uint32_t num_hot = 256;
+    ASSERT_TRUE(pt->allocate_vpn_range(hot, num_hot));
+    std::vector<PageTableEntry *> expected;
+    for (uint32_t i = 0; i < num_hot; i++)
+    {
+        expected.push_back(pt->lookup_entry(hot + i));
+    }
+
+    // Readers hit populated entries while the writer populates and drops others.
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> mismatches{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++)
+    {
+        readers.emplace_back([&]()
+                             {
+            while (!done.load())
+            {
+                for (uint32_t i = 0; i < num_hot; i++)
+                {
+                    if (pt->lookup_entry(hot + i) != expected[i])
+                    {
+                        mismatches++;
+                    }
+                }
+            } });
+    }
+    for (int round = 0; round < 200; round++)
+    {
+        ASSERT_TRUE(pt->reserve_vpn_range(2000, 600));
+        for (VirtualPageNumber vpn = 2000; vpn < 2600; vpn += 7)
+        {
+            ASSERT_NE(pt->lookup_entry(vpn), nullptr);
+        }
+        pt->deallocate_vpn_range(2000, 600);
+    }
+    done = true;
+    for (auto &t : readers)
+    {
+        t.join();
+    }
+
+    EXPECT_EQ(mismatches.load(), 0u);
+    EXPECT_EQ(pt->lookup_entry(2000), nullptr);
+    EXPECT_EQ(pt->get_num_populated_pages(), num_hot);
+}
+
 class PageAllocatorTest : public ::testing::Test
 {
 protected:
@@ -148,6 +227,256 @@ TEST_F(PageAllocatorTest, MultipleAllocations)
     }
 }
 
+// MigrationManager tests share one page table over the allocator's pools and
+// start a manager with the config each of them needs.
+class MigrationManagerTest : public PageAllocatorTest
+{
+protected:
+    void SetUp() override
+    {
+        PageAllocatorTest::SetUp();
+        page_table = std::make_unique<PageTable>(page_size);
+        page_table->initialize(1UL << 30);
+    }
+
+    void TearDown() override
+    {
+        manager.reset();
+        page_table.reset();
+        PageAllocatorTest::TearDown();
+    }
+
+    MigrationManager &start(const MigrationManager::Config &config)
+    {
+        manager = std::make_unique<MigrationManager>(page_table.get(), allocator.get(), config);
+        return *manager;
+    }
+
+    const size_t page_size = DEFAULT_PAGE_SIZE;
+    std::unique_ptr<PageTable> page_table;
+    std::unique_ptr<MigrationManager> manager;
+};
+
+TEST_F(MigrationManagerTest, BatchMigrationCoalescesContiguousPages)
+{
+    ASSERT_TRUE(page_table->allocate_vpn_range(1, 4));
+
+    MigrationManager::Config mig_config;
+    mig_config.async_migration = false;
+    auto &migration = start(mig_config);
+
+    std::vector<MigrationManager::PageTransfer> transfers;
+    for (VirtualPageNumber vpn = 1; vpn <= 4; vpn++)
+    {
+        void *cpu_page = allocator->allocate_cpu_page();
+        std::memset(cpu_page, (int)vpn, page_size);
+        page_table->set_cpu_resident(vpn, cpu_page);
+        transfers.push_back({vpn, cpu_page, allocator->allocate_gpu_page()});
+    }
+
+    auto batch = migration.migrate_batch_cpu_to_gpu(transfers, page_size);
+    EXPECT_EQ(batch.pages, 4u);
+    EXPECT_EQ(batch.runs, 1u);
+    EXPECT_EQ(batch.bytes, 4 * page_size);
+    EXPECT_EQ(migration.get_modeled_time_ns(MigrationDirection::HOST_TO_DEVICE),
+              mig_config.link.transfer_time_ns(4 * page_size, MigrationDirection::HOST_TO_DEVICE));
+    EXPECT_EQ(allocator->gpu_page_ptr(transfers[3].gpu_addr)[0], 4);
+    EXPECT_TRUE(page_table->lookup_entry(3)->resident_on_gpu);
+
+    std::swap(transfers[2].gpu_addr, transfers[3].gpu_addr);
+    batch = migration.migrate_batch_cpu_to_gpu(transfers, page_size);
+    EXPECT_EQ(batch.runs, 3u);
+    EXPECT_EQ(allocator->gpu_page_ptr(transfers[2].gpu_addr)[0], 3);
+}
+
+TEST_F(MigrationManagerTest, CompressedTransfersChargeWireBytes)
+{
+    ASSERT_TRUE(page_table->allocate_vpn_range(1, 2));
+
+    MigrationManager::Config mig_config;
+    mig_config.async_migration = false;
+    mig_config.compression = LinkCompression::PATTERN;
+    auto &migration = start(mig_config);
+    const auto h2d = MigrationDirection::HOST_TO_DEVICE;
+
+    // A zeroed page shrinks to one word per 64-byte block plus tag bits.
+    void *zero_page = allocator->allocate_cpu_page();
+    std::memset(zero_page, 0, page_size);
+    page_table->set_cpu_resident(1, zero_page);
+    migration.migrate_cpu_to_gpu(1, zero_page, allocator->allocate_gpu_page(), page_size);
+    size_t blocks = page_size / 64;
+    EXPECT_EQ(migration.get_wire_bytes(h2d), blocks * 8 + blocks / 8);
+    EXPECT_EQ(migration.get_compressed_transfers(h2d), 1u);
+    EXPECT_LT(migration.get_modeled_time_ns(h2d), mig_config.link.transfer_time_ns(page_size, h2d));
+
+    // Random data does not compress and goes over the link raw.
+    uint8_t *noise = (uint8_t *)allocator->allocate_cpu_page();
+    for (size_t i = 0; i < page_size; i++)
+    {
+        noise[i] = (uint8_t)((i * 2654435761u) >> 13);
+    }
+    page_table->set_cpu_resident(2, noise);
+    uint64_t wire_before = migration.get_wire_bytes(h2d);
+    migration.migrate_cpu_to_gpu(2, noise, allocator->allocate_gpu_page(), page_size);
+    EXPECT_EQ(migration.get_wire_bytes(h2d) - wire_before, page_size);
+    EXPECT_EQ(migration.get_compressed_transfers(h2d), 1u);
+    EXPECT_GT(migration.get_compression_ratio(h2d), 1.0);
+}
+
+TEST_F(MigrationManagerTest, AsyncMigrationFuturesComplete)
+{
+    const VirtualPageNumber num_pages = 16;
+    ASSERT_TRUE(page_table->allocate_vpn_range(1, num_pages));
+
+    MigrationManager::Config mig_config;
+    mig_config.h2d_copy_engines = 2;
+    mig_config.emulate_transfer_time = true;
+    auto &migration = start(mig_config);
+
+    std::vector<uint64_t> gpu_addrs;
+    std::vector<MigrationFuture> futures;
+    for (VirtualPageNumber vpn = 1; vpn <= num_pages; vpn++)
+    {
+        void *cpu_page = allocator->allocate_cpu_page();
+        std::memset(cpu_page, (int)vpn, page_size);
+        page_table->set_cpu_resident(vpn, cpu_page);
+        gpu_addrs.push_back(allocator->allocate_gpu_page());
+        futures.push_back(migration.async_migrate_cpu_to_gpu(vpn, cpu_page, gpu_addrs.back(), page_size));
+    }
+
+    EXPECT_GT(futures[0].get(), 0u);
+    migration.wait_for_migrations();
+    EXPECT_EQ(migration.get_pending_migrations(), 0u);
+    EXPECT_EQ(migration.get_in_flight_migrations(), 0u);
+
+    for (VirtualPageNumber vpn = 1; vpn <= num_pages; vpn++)
+    {
+        EXPECT_EQ(futures[vpn - 1].wait_for(std::chrono::seconds(0)), std::future_status::ready);
+        EXPECT_EQ(allocator->gpu_page_ptr(gpu_addrs[vpn - 1])[page_size - 1], (uint8_t)vpn);
+        // Engines move data only; mapping the page is the submitter's job.
+        EXPECT_FALSE(page_table->lookup_entry(vpn)->resident_on_gpu);
+    }
+}
+
+TEST_F(MigrationManagerTest, CopyEnginesSplitByDirection)
+{
+    const VirtualPageNumber num_pages = 8;
+    ASSERT_TRUE(page_table->allocate_vpn_range(1, num_pages));
+
+    MigrationManager::Config mig_config;
+    mig_config.h2d_copy_engines = 2;
+    mig_config.d2h_copy_engines = 1;
+    mig_config.emulate_transfer_time = true;
+    auto &migration = start(mig_config);
+
+    ASSERT_EQ(migration.get_copy_engines(MigrationDirection::HOST_TO_DEVICE).size(), 2u);
+    ASSERT_EQ(migration.get_copy_engines(MigrationDirection::DEVICE_TO_HOST).size(), 1u);
+
+    for (VirtualPageNumber vpn = 1; vpn <= num_pages; vpn++)
+    {
+        void *cpu_page = allocator->allocate_cpu_page();
+        uint64_t gpu_addr = allocator->allocate_gpu_page();
+        page_table->set_cpu_resident(vpn, cpu_page);
+        if (vpn % 2)
+            migration.async_migrate_cpu_to_gpu(vpn, cpu_page, gpu_addr, page_size);
+        else
+            migration.async_migrate_gpu_to_cpu(vpn, gpu_addr, cpu_page, page_size);
+    }
+    migration.wait_for_migrations();
+    EXPECT_EQ(migration.get_pending_migrations(), 0u);
+
+    uint64_t h2d_jobs = 0;
+    for (const auto &engine : migration.get_copy_engines(MigrationDirection::HOST_TO_DEVICE))
+    {
+        EXPECT_GT(engine->get_jobs_completed(), 0u);
+        h2d_jobs += engine->get_jobs_completed();
+    }
+    const auto &d2h_engine = migration.get_copy_engines(MigrationDirection::DEVICE_TO_HOST)[0];
+    EXPECT_EQ(h2d_jobs, num_pages / 2);
+    EXPECT_EQ(d2h_engine->get_jobs_completed(), num_pages / 2);
+    EXPECT_EQ(d2h_engine->get_bytes_copied(), (num_pages / 2) * page_size);
+    EXPECT_GE(d2h_engine->get_max_queue_depth(), 1u);
+    EXPECT_GT(d2h_engine->get_utilization(), 0.0);
+}
+
+TEST_F(MigrationManagerTest, DemandMigrationsOvertakePrefetches)
+{
+    ASSERT_TRUE(page_table->allocate_vpn_range(1, 7));
+
+    void *cpu_page = allocator->allocate_cpu_page();
+    uint64_t gpu_addr = allocator->allocate_gpu_page();
+
+    auto run = [&](size_t free_frame_reserve, MigrationPriority late_priority, MigrationDirection late_dir)
+    {
+        MigrationManager::Config mig_config;
+        mig_config.h2d_copy_engines = 1;
+        mig_config.d2h_copy_engines = 1;
+        mig_config.free_frame_reserve = free_frame_reserve;
+        mig_config.link = {"slow", 25.0, 26.0, 2000000, 2000000};
+        mig_config.emulate_transfer_time = true;
+        auto &migration = start(mig_config);
+
+        const auto dir = late_dir;
+        VirtualPageNumber vpn = 0;
+        auto submit = [&](MigrationPriority priority)
+        {
+            // Distinct pages so no request is folded into another in-flight one.
+            vpn++;
+            return dir == MigrationDirection::HOST_TO_DEVICE
+                       ? migration.async_migrate_cpu_to_gpu(vpn, cpu_page, gpu_addr, page_size, priority)
+                       : migration.async_migrate_gpu_to_cpu(vpn, gpu_addr, cpu_page, page_size, priority);
+        };
+
+        submit(MigrationPriority::DEMAND);
+        for (int i = 0; i < 5; i++)
+        {
+            submit(MigrationPriority::PREFETCH);
+        }
+        submit(late_priority);
+        migration.wait_for_migrations();
+
+        // Queue wait reflects service order even if this thread is descheduled.
+        const auto &engine = migration.get_copy_engines(dir)[0];
+        return engine->get_avg_wait_us(late_priority) < engine->get_avg_wait_us(MigrationPriority::PREFETCH);
+    };
+
+    EXPECT_TRUE(run(0, MigrationPriority::DEMAND, MigrationDirection::HOST_TO_DEVICE));
+    EXPECT_FALSE(run(0, MigrationPriority::WRITEBACK, MigrationDirection::DEVICE_TO_HOST));
+    EXPECT_TRUE(run(1UL << 20, MigrationPriority::WRITEBACK, MigrationDirection::DEVICE_TO_HOST));
+}
+
+TEST_F(MigrationManagerTest, InFlightMigrationsAreDeduplicated)
+{
+    ASSERT_TRUE(page_table->allocate_vpn_range(1, 1));
+
+    void *cpu_page = allocator->allocate_cpu_page();
+    uint64_t first_frame = allocator->allocate_gpu_page();
+    uint64_t second_frame = allocator->allocate_gpu_page();
+    page_table->set_cpu_resident(1, cpu_page);
+
+    MigrationManager::Config mig_config;
+    mig_config.link = {"slow", 25.0, 26.0, 50000000, 50000000};
+    mig_config.emulate_transfer_time = true;
+    auto &migration = start(mig_config);
+
+    auto first = migration.async_migrate_cpu_to_gpu(1, cpu_page, first_frame, page_size);
+    auto second = migration.async_migrate_cpu_to_gpu(1, cpu_page, second_frame, page_size);
+    EXPECT_TRUE(migration.is_in_flight(1));
+    EXPECT_EQ(migration.get_deduplicated(), 1u);
+
+    // The reverse migration is held back until the fill has landed.
+    auto back = migration.async_migrate_gpu_to_cpu(1, first_frame, cpu_page, page_size);
+    EXPECT_EQ(first.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    back.get();
+    migration.wait_for_migrations();
+
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_EQ(page_table->lookup_entry(1)->gpu_address, 0u);
+    EXPECT_EQ(migration.get_transfers(MigrationDirection::HOST_TO_DEVICE), 1u);
+    EXPECT_EQ(migration.get_transfers(MigrationDirection::DEVICE_TO_HOST), 1u);
+    EXPECT_FALSE(migration.is_in_flight(1));
+}
+
 class TLBTest : public ::testing::Test
 {
 protected:
@@ -274,6 +603,35 @@ TEST_F(LRUPolicyTest, AccessUpdatesRecency)
     EXPECT_EQ(victim, 1);
 }
 
+TEST_F(LRUPolicyTest, CleanVictimPreferredWithinWindow)
+{
+    for (int i = 1; i <= 4; i++)
+    {
+        policy->on_page_allocated(i);
+    }
+    auto is_clean = [](VirtualPageNumber vpn)
+    { return vpn == 3; };
+
+    EXPECT_EQ(policy->select_clean_victim(is_clean, 2), 1u);
+    EXPECT_EQ(policy->select_clean_victim(is_clean, 2), 3u);
+
+    // Passed-over dirty pages keep their place at the cold end.
+    EXPECT_EQ(policy->select_victim(), 2u);
+}
+
+TEST_F(LRUPolicyTest, DeclinedVictimStaysColdest)
+{
+    for (int i = 1; i <= 3; i++)
+    {
+        policy->on_page_allocated(i);
+    }
+
+    EXPECT_EQ(policy->select_victim(), 1u);
+    policy->on_victim_declined(1);
+    EXPECT_EQ(policy->select_victim(), 1u);
+    EXPECT_EQ(policy->select_victim(), 2u);
+}
+
 class CLOCKPolicyTest : public ::testing::Test
 {
 protected:
@@ -301,129 +659,2022 @@ TEST_F(CLOCKPolicyTest, BasicEviction)
     EXPECT_GE(victim, 0);
 }
 
-class VirtualMemoryManagerTest : public ::testing::Test
+TEST_F(CLOCKPolicyTest, ReferencedPagesGetSecondChance)
 {
-protected:
-    void SetUp() override
+    for (int i = 1; i <= 4; i++)
     {
-        VMConfig config;
-        config.page_size = 64 * 1024;
-        config.gpu_memory = 512UL * 1024 * 1024;
-        config.replacement_policy = PageReplacementPolicy::LRU;
-        config.use_gpu_simulator = true;
-        config.log_level = LogLevel::ERROR; 
+        policy->on_page_allocated(i);
+    }
 
-        VirtualMemoryManager::instance().initialize(config);
+    
+    EXPECT_EQ(policy->select_victim(), 1u);
+
+    policy->on_page_access(2);
+    EXPECT_EQ(policy->select_victim(), 3u);
+}
+
+TEST_F(CLOCKPolicyTest, DeclinedVictimIsNextCandidate)
+{
+    for (int i = 1; i <= 4; i++)
+    {
+        policy->on_page_allocated(i);
     }
 
-    void TearDown() override
+    EXPECT_EQ(policy->select_victim(), 1u);
+    policy->on_victim_declined(1);
+    EXPECT_EQ(policy->select_victim(), 1u);
+    EXPECT_EQ(policy->select_victim(), 2u);
+}
+
+TEST_F(CLOCKPolicyTest, PassedOverDirtyPagesStayNextCandidates)
+{
+    for (int i = 1; i <= 4; i++)
     {
-        VirtualMemoryManager::instance().shutdown();
+        policy->on_page_allocated(i);
     }
-};
+    auto is_clean = [](VirtualPageNumber vpn)
+    { return vpn == 3; };
 
-TEST_F(VirtualMemoryManagerTest, AllocateAndFree)
+    EXPECT_EQ(policy->select_clean_victim(is_clean, 3), 3u);
+    EXPECT_EQ(policy->select_victim(), 1u);
+    EXPECT_EQ(policy->select_victim(), 2u);
+}
+
+TEST(BeladyPolicyTest, EvictsPageUsedFarthestInFuture)
 {
-    size_t size = 4UL * 1024 * 1024; 
+    std::vector<VirtualPageNumber> trace = {1, 2, 3, 1, 2, 4, 1, 2, 3};
+    BeladyPolicy policy(trace);
 
-    void *ptr = VirtualMemoryManager::instance().allocate(size);
-    ASSERT_NE(ptr, nullptr);
+    policy.on_page_allocated(1);
+    policy.on_page_allocated(2);
+    policy.on_page_allocated(3);
+    policy.on_page_access(1);
+    policy.on_page_access(2);
 
-    VirtualMemoryManager::instance().free(ptr);
+    
+    EXPECT_EQ(policy.select_victim(), 3u);
+    policy.on_page_allocated(4);
+
+    EXPECT_EQ(policy.select_victim(), 4u);
 }
 
-TEST_F(VirtualMemoryManagerTest, WriteAndRead)
+TEST(TraceSimulatorTest, OptimalIsLowerBoundOnLoop)
 {
-    size_t size = 1024 * 1024; 
-    void *ptr = VirtualMemoryManager::instance().allocate(size);
-    ASSERT_NE(ptr, nullptr);
+    std::vector<TraceAccess> trace;
+    for (int pass = 0; pass < 20; pass++)
+    {
+        for (VirtualPageNumber vpn = 1; vpn <= 5; vpn++)
+        {
+            trace.push_back({vpn, pass == 0});
+        }
+    }
 
-    
-    uint32_t test_value = 0xDEADBEEF;
-    VirtualMemoryManager::instance().write_to_vaddr(ptr, &test_value, sizeof(test_value));
+    TraceSimulator::Config config;
+    config.gpu_frames = 4;
+    TraceSimulator sim(config);
+
+    LRUPolicy lru(config.gpu_frames);
+    auto lru_result = sim.run(trace, lru, "LRU");
+    auto opt_result = sim.run_optimal(trace);
+
+    EXPECT_EQ(lru_result.accesses, trace.size());
+    EXPECT_EQ(lru_result.misses, trace.size());
+    EXPECT_LT(opt_result.misses, lru_result.misses);
+    EXPECT_EQ(opt_result.hits + opt_result.misses, trace.size());
+    EXPECT_EQ(lru_result.evictions, trace.size() - config.gpu_frames);
+    EXPECT_GT(lru_result.writebacks, 0u);
+    EXPECT_EQ(lru_result.migrated_bytes, (lru_result.misses + lru_result.writebacks) * config.page_size);
+}
 
-    
-    uint32_t read_value = 0;
-    VirtualMemoryManager::instance().read_from_vaddr(ptr, &read_value, sizeof(read_value));
+TEST(TraceSimulatorTest, CoarserPagesMergeAccesses)
+{
+    std::vector<TraceAccess> trace;
+    for (VirtualPageNumber vpn = 0; vpn < 64; vpn++)
+    {
+        trace.push_back({vpn, false});
+    }
 
-    EXPECT_EQ(read_value, test_value);
+    TraceSimulator::Config config;
+    config.gpu_frames = 64;
+    config.trace_page_size = 64 * 1024;
+    config.page_size = 2 * 1024 * 1024;
+    TraceSimulator sim(config);
 
-    VirtualMemoryManager::instance().free(ptr);
+    LRUPolicy lru(config.gpu_frames);
+    EXPECT_EQ(sim.run(trace, lru, "LRU").misses, 2u);
 }
 
-TEST_F(VirtualMemoryManagerTest, TouchPage)
+TEST(TraceSimulatorTest, ZeroFramesReplaysNothing)
 {
-    size_t size = 1024 * 1024;
-    void *ptr = VirtualMemoryManager::instance().allocate(size);
-    ASSERT_NE(ptr, nullptr);
+    std::vector<TraceAccess> trace = {{1, false}, {2, true}};
 
-    auto &perf_before = VirtualMemoryManager::instance().get_perf_counters();
-    uint64_t faults_before = perf_before.total_page_faults;
+    TraceSimulator::Config config;
+    config.gpu_frames = 0;
+    TraceSimulator sim(config);
 
-    VirtualMemoryManager::instance().touch_page(ptr);
+    LRUPolicy lru(1);
+    auto result = sim.run(trace, lru, "LRU");
+    EXPECT_EQ(result.accesses, 0u);
+    EXPECT_EQ(result.evictions, 0u);
+}
 
-    VirtualMemoryManager::instance().free(ptr);
+TEST(MPMCQueueTest, BoundedAndLossless)
+{
+    MPMCQueue<uint64_t> queue(4);
+    for (uint64_t i = 0; i < 4; i++)
+    {
+        EXPECT_TRUE(queue.try_push(i));
+    }
+    EXPECT_FALSE(queue.try_push(99));
+
+    uint64_t value = 0;
+    EXPECT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, 0u);
+    while (queue.try_pop(value))
+    {
+    }
+    EXPECT_TRUE(queue.empty());
+
+    const int producers = 3;
+    const uint64_t per_producer = 20000;
+    MPMCQueue<uint64_t> shared(64);
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> popped{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&]()
+                             {
+            for (uint64_t i = 1; i <= per_producer; i++)
+            {
+                while (!shared.try_push(i))
+                {
+                    std::this_thread::yield();
+                }
+            } });
+    }
+    for (int c = 0; c < 2; c++)
+    {
+        threads.emplace_back([&]()
+                             {
+            uint64_t v;
+            while (popped.load() < producers * per_producer)
+            {
+                if (shared.try_pop(v))
+                {
+                    sum += v;
+                    popped++;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            } });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    EXPECT_EQ(popped.load(), producers * per_producer);
+    EXPECT_EQ(sum.load(), producers * per_producer * (per_producer + 1) / 2);
 }
 
-TEST_F(VirtualMemoryManagerTest, LargeAllocation)
+class CountingPolicy : public ReplacementPolicy
 {
-    size_t size = 256UL * 1024 * 1024; 
-    void *ptr = VirtualMemoryManager::instance().allocate(size);
+public:
+    void on_page_access(VirtualPageNumber) override { accesses++; }
+    void on_page_access_batch(const VirtualPageNumber *, size_t count) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        accesses += count;
+        batches++;
+    }
+    void on_page_allocated(VirtualPageNumber) override {}
+    void on_page_freed(VirtualPageNumber) override {}
+    VirtualPageNumber select_victim() override { return 0; }
+    void reset() override { accesses = batches = 0; }
+
+    std::mutex mutex;
+    uint64_t accesses = 0;
+    uint64_t batches = 0;
+};
 
-    if (ptr)
+TEST(AccessBatcherTest, DrainsAtThresholdAndOnDemand)
+{
+    CountingPolicy policy;
+    AccessBatcher batcher(&policy, 8);
+
+    for (VirtualPageNumber vpn = 1; vpn <= 20; vpn++)
     {
-        
-        size_t page_size = 64 * 1024;
-        for (size_t offset = 0; offset < size; offset += page_size * 10)
-        {
-            VirtualMemoryManager::instance().touch_page((uint8_t *)ptr + offset);
-        }
+        batcher.record(vpn);
+    }
+    EXPECT_EQ(policy.accesses, 16u);
+    EXPECT_EQ(policy.batches, 2u);
 
-        VirtualMemoryManager::instance().free(ptr);
+    batcher.drain_all();
+    EXPECT_EQ(policy.accesses, 20u);
+    EXPECT_EQ(batcher.get_recorded(), 20u);
+}
+
+TEST(AccessBatcherTest, ConcurrentRecordersLoseNothing)
+{
+    CountingPolicy policy;
+    AccessBatcher batcher(&policy, 16);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&batcher, t]()
+                             {
+            for (VirtualPageNumber i = 0; i < 10000; i++)
+            {
+                batcher.record(t * 100000 + i);
+            } });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
     }
+
+    batcher.drain_all();
+    EXPECT_EQ(policy.accesses, 40000u);
+    EXPECT_LE(policy.batches, 40000u / 16 + 4);
 }
 
-TEST_F(VirtualMemoryManagerTest, DeviceMappedHelper)
+TEST(AccessBatcherTest, ExitedThreadsReleaseTheirBuffers)
 {
+    CountingPolicy policy;
+    AccessBatcher batcher(&policy, 16);
+
+    for (int t = 0; t < 8; t++)
     {
-        DeviceMapped<uint32_t> arr(1024);
-        EXPECT_EQ(arr.size(), 1024);
-        ASSERT_NE(arr.get(), nullptr);
+        std::thread([&batcher]()
+                    { batcher.record(1); })
+            .join();
+    }
 
-        
-        arr[0] = 42;
-        arr[1] = 99;
+    // Each exiting thread flushed its pending access and dropped its buffer.
+    EXPECT_EQ(batcher.get_thread_buffers(), 0u);
+    EXPECT_EQ(policy.accesses, 8u);
+}
 
-        EXPECT_EQ(arr[0], 42);
-        EXPECT_EQ(arr[1], 99);
-    } 
+TEST(AccessBatcherTest, ReusedSlotStartsWithFreshBuffer)
+{
+    CountingPolicy first_policy;
+    CountingPolicy second_policy;
+    {
+        AccessBatcher first(&first_policy, 16);
+        first.record(1);
+    }
+    EXPECT_EQ(first_policy.accesses, 1u);
+
+    // Same thread, same slot: the stale entry must not be mistaken for this batcher's.
+    AccessBatcher second(&second_policy, 16);
+    second.record(2);
+    second.drain_all();
+    EXPECT_EQ(second_policy.accesses, 1u);
+    EXPECT_EQ(first_policy.accesses, 1u);
+    EXPECT_EQ(second.get_thread_buffers(), 1u);
 }
 
-TEST_F(VirtualMemoryManagerTest, DataIntegrity)
+TEST(AccessBatcherTest, LRUSeesBatchedRecency)
 {
-    size_t size = 8 * 1024 * 1024; 
-    void *ptr = VirtualMemoryManager::instance().allocate(size);
-    ASSERT_NE(ptr, nullptr);
+    LRUPolicy lru(16);
+    AccessBatcher batcher(&lru, 4);
 
-    
-    std::vector<uint32_t> pattern(size / sizeof(uint32_t));
-    for (size_t i = 0; i < pattern.size(); i++)
+    lru.on_page_allocated(1);
+    lru.on_page_allocated(2);
+    batcher.record(1);
+
+    batcher.drain_all();
+    EXPECT_EQ(lru.select_victim(), 2u);
+}
+
+TEST(StreamTest, EventsCompleteInSubmissionOrder)
+{
+    Stream stream;
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    std::vector<int> order;
+
+    stream.enqueue([&]()
+                   {
+        opened.wait();
+        order.push_back(1); });
+    Event first = stream.record();
+    stream.enqueue([&]()
+                   { order.push_back(2); });
+    Event second = stream.record();
+
+    EXPECT_FALSE(first.query());
+    EXPECT_FALSE(stream.query());
+    gate.set_value();
+    second.synchronize();
+    EXPECT_TRUE(first.query());
+    EXPECT_EQ(order, (std::vector<int>{1, 2}));
+}
+
+TEST(FaultBufferTest, BatchesAreSortedAndDeduplicated)
+{
+    FaultBuffer::Config config;
+    config.batch_size = 8;
+    config.batch_window_us = 1000000;
+    std::vector<std::vector<VirtualPageNumber>> batches;
+    FaultBuffer buffer(config, [&](const std::vector<VirtualPageNumber> &vpns, std::vector<uint64_t> &throttle_us)
+                       {
+        batches.push_back(vpns);
+        throttle_us[2] = 7; });
+
+    std::vector<std::thread> threads;
+    std::vector<uint64_t> throttled(8, 0);
+    for (int i = 0; i < 8; i++)
     {
-        pattern[i] = i ^ 0xDEADBEEF;
+        threads.emplace_back([&buffer, &throttled, i]()
+                             { throttled[i] = buffer.fault_and_wait(13 - i % 4); });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
     }
 
-    VirtualMemoryManager::instance().write_to_vaddr(ptr, pattern.data(), size);
+    ASSERT_EQ(batches.size(), 1u);
+    EXPECT_EQ(batches[0], (std::vector<VirtualPageNumber>{10, 11, 12, 13}));
+    // Every access to VPN 12 gets the throttle back; the others replay at once.
+    EXPECT_EQ(throttled, (std::vector<uint64_t>{0, 7, 0, 0, 0, 7, 0, 0}));
+    EXPECT_EQ(buffer.get_faults(), 8u);
+    EXPECT_EQ(buffer.get_duplicates(), 4u);
+    EXPECT_EQ(buffer.get_max_batch(), 8u);
+}
 
-    
-    std::vector<uint32_t> read_back(size / sizeof(uint32_t));
-    VirtualMemoryManager::instance().read_from_vaddr(ptr, read_back.data(), size);
+TEST(ThrashDetectorTest, RepeatedRefaultsWithinWindowTriggerMitigation)
+{
+    ThrashDetector::Config config;
+    config.threshold = 3;
+    config.window_us = 1000;
+    config.pin_duration_us = 500;
+    ThrashDetector detector(config);
+
+    uint64_t now = 10000;
+    for (int i = 0; i < 2; i++)
+    {
+        detector.on_eviction(5, now);
+        EXPECT_EQ(detector.on_fault(5, now + 10), ThrashMitigation::NONE);
+        now += 20;
+    }
 
-    for (size_t i = 0; i < pattern.size(); i++)
+    detector.on_eviction(5, now);
+    EXPECT_EQ(detector.on_fault(5, now + 10), ThrashMitigation::PIN);
+    EXPECT_TRUE(detector.is_pinned(5, now + 20));
+    EXPECT_FALSE(detector.is_pinned(5, now + 1000));
+    EXPECT_EQ(detector.get_thrash_events(), 1u);
+}
+
+TEST(ThrashDetectorTest, SlowRefaultsAreNotThrashing)
+{
+    ThrashDetector::Config config;
+    config.threshold = 2;
+    config.window_us = 100;
+    ThrashDetector detector(config);
+
+    uint64_t now = 10000;
+    for (int i = 0; i < 5; i++)
     {
-        EXPECT_EQ(read_back[i], pattern[i]) << "Data mismatch at index " << i;
+        detector.on_eviction(9, now);
+        EXPECT_EQ(detector.on_fault(9, now + 500), ThrashMitigation::NONE);
+        now += 1000;
     }
+    EXPECT_EQ(detector.on_fault(9, now), ThrashMitigation::NONE);
+}
 
-    VirtualMemoryManager::instance().free(ptr);
+TEST(ThrashDetectorTest, RegionIsDroppedOnceItsPagesAreFreed)
+{
+    ThrashDetector::Config config;
+    config.region_pages = 16;
+    ThrashDetector detector(config);
+
+    detector.on_eviction(32, 1000);
+    detector.on_eviction(33, 1000);
+    detector.on_eviction(33, 2000);
+    EXPECT_EQ(detector.get_tracked_regions(), 1u);
+
+    detector.on_page_freed(32);
+    EXPECT_EQ(detector.get_tracked_regions(), 1u);
+    detector.on_page_freed(33);
+    EXPECT_EQ(detector.get_tracked_regions(), 0u);
+}
+
+TEST(StridePrefetcherTest, ConfirmedStrideRunsAheadOfTouches)
+{
+    StridePrefetcher::Config config;
+    config.min_depth = 2;
+    config.max_depth = 8;
+    StridePrefetcher prefetcher(config);
+
+    EXPECT_EQ(prefetcher.on_access(10).count, 0u);
+    EXPECT_EQ(prefetcher.on_access(13).count, 0u);
+    auto first = prefetcher.on_access(16);
+    EXPECT_EQ(first.start, 19u);
+    EXPECT_EQ(first.stride, 3);
+    EXPECT_EQ(first.count, 2u);
+
+    // Touching the first prefetched page tops the window up at twice the depth.
+    auto next = prefetcher.on_access(19);
+    EXPECT_EQ(next.start, 25u);
+    EXPECT_EQ(next.count, 3u);
+    EXPECT_EQ(prefetcher.on_access(22).count, 0u);
+
+    // A far jump starts a separate stream.
+    EXPECT_EQ(prefetcher.on_access(5000).count, 0u);
+    EXPECT_EQ(prefetcher.get_issued(), 5u);
+}
+
+TEST(StridePrefetcherTest, WastedPrefetchesShrinkDepthCap)
+{
+    StridePrefetcher::Config config;
+    config.min_depth = 2;
+    config.max_depth = 16;
+    config.accuracy_window = 4;
+    StridePrefetcher prefetcher(config);
+
+    for (int i = 0; i < 4; i++)
+    {
+        prefetcher.on_wasted();
+    }
+    EXPECT_EQ(prefetcher.get_depth_cap(), 8u);
+    for (int i = 0; i < 4; i++)
+    {
+        prefetcher.on_useful();
+    }
+    EXPECT_EQ(prefetcher.get_depth_cap(), 16u);
+    EXPECT_DOUBLE_EQ(prefetcher.get_accuracy(), 0.5);
+}
+
+TEST(TreePrefetcherTest, PromotesLargestDenseSubtree)
+{
+    TreePrefetcher::Config config;
+    config.region_bytes = 16 * 4096;
+    TreePrefetcher prefetcher(config, 4096);
+    EXPECT_EQ(prefetcher.get_region_pages(), 16u);
+    EXPECT_EQ(prefetcher.get_num_levels(), 5u);
+
+    for (VirtualPageNumber vpn = 32; vpn < 37; vpn++)
+    {
+        prefetcher.on_resident(vpn);
+    }
+
+    // [32, 40) holds 6 of 8 pages with the fault; [32, 48) only 6 of 16.
+    auto promotion = prefetcher.on_fault(37);
+    EXPECT_EQ(promotion.start, 32u);
+    EXPECT_EQ(promotion.num_pages, 8u);
+    EXPECT_EQ(promotion.level, 3u);
+    EXPECT_EQ(prefetcher.get_promotions(3), 1u);
+    EXPECT_EQ(prefetcher.get_pages_promoted(), 2u);
+
+    prefetcher.on_evicted(33);
+    prefetcher.on_evicted(34);
+    EXPECT_EQ(prefetcher.on_fault(44).num_pages, 0u);
+}
+
+TEST(FrequencySketchTest, EstimatesTrackAccessCounts)
+{
+    FrequencySketch sketch(1024);
+
+    for (int i = 0; i < 5; i++)
+    {
+        sketch.increment(42);
+    }
+    sketch.increment(7);
+
+    EXPECT_GE(sketch.frequency(42), 5u);
+    EXPECT_GE(sketch.frequency(7), 1u);
+    EXPECT_GT(sketch.frequency(42), sketch.frequency(7));
+    EXPECT_LE(sketch.size_bytes(), 4096u);
+}
+
+TEST(FrequencySketchTest, CountersSaturateAndAge)
+{
+    FrequencySketch sketch(16);
+
+    for (int i = 0; i < 100; i++)
+    {
+        sketch.increment(1);
+    }
+    EXPECT_LE(sketch.frequency(1), 15u);
+
+    uint32_t before = sketch.frequency(1);
+    for (uint64_t vpn = 1000; vpn < 1000 + sketch.get_sample_size(); vpn++)
+    {
+        sketch.increment(vpn);
+    }
+    EXPECT_LT(sketch.frequency(1), before);
+}
+
+TEST(TinyLFUAdmissionFilterTest, RejectsColdCandidate)
+{
+    TinyLFUAdmissionFilter filter(64);
+
+    for (int i = 0; i < 8; i++)
+    {
+        filter.record_access(10);
+    }
+    filter.record_access(20);
+
+    EXPECT_FALSE(filter.admit(20, 10));
+    EXPECT_TRUE(filter.admit(10, 20));
+    EXPECT_EQ(filter.get_rejected(), 1u);
+    EXPECT_EQ(filter.get_admitted(), 1u);
+}
+
+class VirtualMemoryManagerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        VMConfig config;
+        config.page_size = 64 * 1024;
+        config.gpu_memory = 512UL * 1024 * 1024;
+        config.replacement_policy = PageReplacementPolicy::LRU;
+        config.use_gpu_simulator = true;
+        config.log_level = LogLevel::ERROR; 
+
+        VirtualMemoryManager::instance().initialize(config);
+    }
+
+    void TearDown() override
+    {
+        VirtualMemoryManager::instance().shutdown();
+    }
+};
+
+TEST_F(VirtualMemoryManagerTest, AllocateAndFree)
+{
+    size_t size = 4UL * 1024 * 1024; 
+
+    void *ptr = VirtualMemoryManager::instance().allocate(size);
+    ASSERT_NE(ptr, nullptr);
+
+    VirtualMemoryManager::instance().free(ptr);
+}
+
+TEST_F(VirtualMemoryManagerTest, WriteAndRead)
+{
+    size_t size = 1024 * 1024; 
+    void *ptr = VirtualMemoryManager::instance().allocate(size);
+    ASSERT_NE(ptr, nullptr);
+
+    
+    uint32_t test_value = 0xDEADBEEF;
+    VirtualMemoryManager::instance().write_to_vaddr(ptr, &test_value, sizeof(test_value));
+
+    
+    uint32_t read_value = 0;
+    VirtualMemoryManager::instance().read_from_vaddr(ptr, &read_value, sizeof(read_value));
+
+    EXPECT_EQ(read_value, test_value);
+
+    VirtualMemoryManager::instance().free(ptr);
+}
+
+TEST_F(VirtualMemoryManagerTest, TouchPage)
+{
+    size_t size = 1024 * 1024;
+    void *ptr = VirtualMemoryManager::instance().allocate(size);
+    ASSERT_NE(ptr, nullptr);
+
+    auto &perf_before = VirtualMemoryManager::instance().get_perf_counters();
+    uint64_t faults_before = perf_before.total_page_faults;
+
+    VirtualMemoryManager::instance().touch_page(ptr);
+
+    VirtualMemoryManager::instance().free(ptr);
+}
+
+TEST_F(VirtualMemoryManagerTest, LargeAllocation)
+{
+    size_t size = 256UL * 1024 * 1024; 
+    void *ptr = VirtualMemoryManager::instance().allocate(size);
+
+    if (ptr)
+    {
+        
+        size_t page_size = 64 * 1024;
+        for (size_t offset = 0; offset < size; offset += page_size * 10)
+        {
+            VirtualMemoryManager::instance().touch_page((uint8_t *)ptr + offset);
+        }
+
+        VirtualMemoryManager::instance().free(ptr);
+    }
+}
+
+TEST_F(VirtualMemoryManagerTest, DeviceMappedHelper)
+{
+    {
+        DeviceMapped<uint32_t> arr(1024);
+        EXPECT_EQ(arr.size(), 1024);
+        ASSERT_NE(arr.get(), nullptr);
+
+        
+        arr[0] = 42;
+        arr[1] = 99;
+
+        EXPECT_EQ(arr[0], 42);
+        EXPECT_EQ(arr[1], 99);
+    } 
+}
+
+TEST_F(VirtualMemoryManagerTest, DataIntegrity)
+{
+    size_t size = 8 * 1024 * 1024; 
+    void *ptr = VirtualMemoryManager::instance().allocate(size);
+    ASSERT_NE(ptr, nullptr);
+
+    
+    std::vector<uint32_t> pattern(size / sizeof(uint32_t));
+    for (size_t i = 0; i < pattern.size(); i++)
+    {
+        pattern[i] = i ^ 0xDEADBEEF;
+    }
+
+    VirtualMemoryManager::instance().write_to_vaddr(ptr, pattern.data(), size);
+
+    
+    std::vector<uint32_t> read_back(size / sizeof(uint32_t));
+    VirtualMemoryManager::instance().read_from_vaddr(ptr, read_back.data(), size);
+
+    for (size_t i = 0; i < pattern.size(); i++)
+    {
+        EXPECT_EQ(read_back[i], pattern[i]) << "Data mismatch at index " << i;
+    }
+
+    VirtualMemoryManager::instance().free(ptr);
+}
+
+// Shared setup for manager-level tests: each fixture adjusts the simulator
+// defaults in configure() for the feature it exercises.
+class ManagedVMTest : public ::testing::Test
+{
+protected:
+    virtual void configure(VMConfig &) {}
+
+    void SetUp() override
+    {
+        restart([](VMConfig &) {});
+    }
+
+    // Re-initializes with the fixture's config plus a test-specific tweak.
+    void restart(const std::function<void(VMConfig &)> &adjust)
+    {
+        VMConfig config;
+        config.page_size = page_size;
+        config.use_gpu_simulator = true;
+        config.log_level = LogLevel::ERROR;
+        configure(config);
+        adjust(config);
+        page_size = config.page_size;
+
+        auto &vm = VirtualMemoryManager::instance();
+        vm.shutdown();
+        vm.initialize(config);
+    }
+
+    void TearDown() override
+    {
+        VirtualMemoryManager::instance().shutdown();
+    }
+
+    PageTableEntry *entry_of(void *ptr)
+    {
+        return VirtualMemoryManager::instance().get_page_table()->lookup_entry(vaddr_to_vpn((Address)ptr, page_size));
+    }
+
+    bool on_gpu(void *ptr)
+    {
+        auto entry = entry_of(ptr);
+        return entry && entry->resident_on_gpu;
+    }
+
+    uint8_t *device_copy(void *ptr)
+    {
+        return VirtualMemoryManager::instance().get_allocator()->gpu_page_ptr(entry_of(ptr)->gpu_address);
+    }
+
+    size_t page_size = 4096;
+};
+
+class AdmissionFilterVMTest : public ManagedVMTest
+{
+protected:
+    void configure(VMConfig &config) override
+    {
+        config.page_size = 64 * 1024;
+        config.gpu_memory = 4 * config.page_size;
+        config.cpu_memory = 64 * config.page_size;
+        config.enable_admission_filter = true;
+    }
+};
+
+TEST_F(AdmissionFilterVMTest, OneShotPageDoesNotDisplaceHotPages)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *base = (uint8_t *)vm.allocate(16 * page_size);
+    ASSERT_NE(base, nullptr);
+
+    for (int round = 0; round < 4; round++)
+    {
+        for (int p = 0; p < 4; p++)
+        {
+            vm.touch_page(base + p * page_size);
+        }
+    }
+
+    vm.reset_counters();
+    vm.touch_page(base + 8 * page_size);
+
+    EXPECT_FALSE(on_gpu(base + 8 * page_size));
+    EXPECT_EQ(vm.get_perf_counters().admission_rejections, 1u);
+    EXPECT_EQ(vm.get_perf_counters().remote_accesses, 1u);
+    EXPECT_EQ(vm.get_perf_counters().evictions, 0u);
+    for (int p = 0; p < 4; p++)
+    {
+        EXPECT_TRUE(on_gpu(base + p * page_size));
+    }
+
+    vm.free(base);
+}
+
+TEST_F(AdmissionFilterVMTest, BatchedFaultsEvictOnlyForAdmittedMigrations)
+{
+    restart([](VMConfig &config)
+            { config.enable_fault_buffer = true; });
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *base = (uint8_t *)vm.allocate(16 * page_size);
+    ASSERT_NE(base, nullptr);
+    vm.advise(base + 9 * page_size, page_size, Advice::SET_PREFERRED_LOCATION, Location::CPU);
+    std::vector<uint8_t> data(page_size, 0x11);
+    vm.write_to_vaddr(base + 9 * page_size, data.data(), page_size);
+
+    for (int round = 0; round < 4; round++)
+    {
+        for (int p = 0; p < 4; p++)
+        {
+            vm.touch_page(base + p * page_size);
+        }
+    }
+
+    // A one-shot page is rejected and a CPU-preferred page maps remotely: neither
+    // needs a frame, so the full GPU evicts nothing for them.
+    vm.reset_counters();
+    vm.touch_page(base + 8 * page_size);
+    vm.touch_page(base + 9 * page_size);
+
+    EXPECT_FALSE(on_gpu(base + 8 * page_size));
+    EXPECT_FALSE(on_gpu(base + 9 * page_size));
+    EXPECT_EQ(vm.get_perf_counters().admission_rejections, 1u);
+    EXPECT_EQ(vm.get_perf_counters().remote_accesses, 2u);
+    EXPECT_EQ(vm.get_perf_counters().evictions, 0u);
+    for (int p = 0; p < 4; p++)
+    {
+        EXPECT_TRUE(on_gpu(base + p * page_size));
+    }
+
+    vm.free(base);
+}
+
+TEST_F(AdmissionFilterVMTest, FrequentlyUsedPageIsEventuallyAdmitted)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *base = (uint8_t *)vm.allocate(16 * page_size);
+    ASSERT_NE(base, nullptr);
+
+    for (int p = 0; p < 4; p++)
+    {
+        vm.touch_page(base + p * page_size);
+    }
+
+    for (int i = 0; i < 8 && !on_gpu(base + 8 * page_size); i++)
+    {
+        vm.touch_page(base + 8 * page_size);
+    }
+
+    EXPECT_TRUE(on_gpu(base + 8 * page_size));
+    EXPECT_EQ(vm.get_perf_counters().evictions, 1u);
+
+    vm.free(base);
+}
+
+class ThrashingVMTest : public ManagedVMTest
+{
+protected:
+    void configure(VMConfig &config) override
+    {
+        config.page_size = 64 * 1024;
+        config.gpu_memory = 2 * config.page_size;
+        config.cpu_memory = 16 * config.page_size;
+        config.enable_thrash_detection = true;
+        config.thrash_detection.threshold = 2;
+        config.thrash_detection.window_us = 10 * 1000 * 1000;
+        config.thrash_detection.pin_duration_us = 10 * 1000 * 1000;
+        config.thrash_detection.remote_duration_us = 10 * 1000 * 1000;
+        config.thrash_detection.mitigation = mitigation;
+    }
+
+    void cycle(uint8_t *base, int rounds)
+    {
+        for (int r = 0; r < rounds; r++)
+        {
+            for (int p = 0; p < 3; p++)
+            {
+                VirtualMemoryManager::instance().touch_page(base + p * 64 * 1024, true);
+            }
+        }
+    }
+
+    ThrashMitigation mitigation = ThrashMitigation::PIN;
+};
+
+class RemoteThrashingVMTest : public ThrashingVMTest
+{
+protected:
+    RemoteThrashingVMTest() { mitigation = ThrashMitigation::REMOTE; }
+};
+
+TEST_F(ThrashingVMTest, PinningStopsPingPong)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *base = (uint8_t *)vm.allocate(3 * 64 * 1024);
+    ASSERT_NE(base, nullptr);
+
+    cycle(base, 4);
+    auto &perf = vm.get_perf_counters();
+    EXPECT_GT(perf.thrashing_events, 0u);
+    EXPECT_EQ(perf.thrashing_events, perf.thrash_pins);
+
+    uint64_t evictions = perf.evictions;
+    cycle(base, 10);
+    EXPECT_LT(perf.evictions - evictions, 30u);
+    EXPECT_GT(perf.remote_accesses, 0u);
+
+    vm.free(base);
+}
+
+TEST_F(ThrashingVMTest, HostReadsCountAsEvictions)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *base = (uint8_t *)vm.allocate(64 * 1024);
+    ASSERT_NE(base, nullptr);
+
+    // One page bouncing between kernel touches and host reads never runs out of
+    // device frames, so only the reads' migrations back can reveal the ping-pong.
+    vm.reset_counters();
+    uint8_t value;
+    for (int r = 0; r < 4; r++)
+    {
+        vm.touch_page(base, true);
+        vm.read_from_vaddr(base, &value, 1);
+    }
+    auto &perf = vm.get_perf_counters();
+    EXPECT_EQ(perf.evictions, 0u);
+    EXPECT_GT(perf.thrashing_events, 0u);
+
+    vm.free(base);
+}
+
+TEST_F(RemoteThrashingVMTest, RemoteMappingStopsMigrations)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *base = (uint8_t *)vm.allocate(3 * 64 * 1024);
+    ASSERT_NE(base, nullptr);
+
+    cycle(base, 4);
+    auto &perf = vm.get_perf_counters();
+    EXPECT_GT(perf.thrash_remote_maps, 0u);
+
+    uint64_t migrations = perf.cpu_to_gpu_migrations;
+    cycle(base, 10);
+    EXPECT_LT(perf.cpu_to_gpu_migrations - migrations, 30u);
+
+    vm.free(base);
+}
+
+class PinningVMTest : public ManagedVMTest
+{
+protected:
+    void configure(VMConfig &config) override
+    {
+        config.page_size = 64 * 1024;
+        config.gpu_memory = 8 * config.page_size;
+        config.cpu_memory = 64 * config.page_size;
+        config.max_pinned_gpu_fraction = 0.5;
+    }
+};
+
+TEST_F(PinningVMTest, PinnedPagesSurviveEvictionPressure)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *critical = (uint8_t *)vm.allocate(2 * page_size);
+    uint8_t *batch = (uint8_t *)vm.allocate(32 * page_size);
+    ASSERT_NE(critical, nullptr);
+    ASSERT_NE(batch, nullptr);
+
+    ASSERT_TRUE(vm.pin(critical, 2 * page_size));
+    EXPECT_TRUE(on_gpu(critical));
+    EXPECT_TRUE(on_gpu(critical + page_size));
+    EXPECT_EQ(vm.get_gpu_pages_pinned(), 2u);
+
+    for (int pass = 0; pass < 3; pass++)
+    {
+        for (int p = 0; p < 32; p++)
+        {
+            vm.touch_page(batch + p * page_size);
+        }
+    }
+
+    EXPECT_GT(vm.get_perf_counters().evictions, 0u);
+    EXPECT_TRUE(on_gpu(critical));
+    EXPECT_TRUE(on_gpu(critical + page_size));
+
+    vm.unpin(critical, 2 * page_size);
+    EXPECT_EQ(vm.get_gpu_pages_pinned(), 0u);
+    for (int p = 0; p < 32; p++)
+    {
+        vm.touch_page(batch + p * page_size);
+    }
+    EXPECT_FALSE(on_gpu(critical));
+
+    vm.free(batch);
+    vm.free(critical);
+}
+
+TEST_F(PinningVMTest, PinCountsNest)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(page_size);
+    ASSERT_NE(buf, nullptr);
+
+    ASSERT_TRUE(vm.pin(buf, 16));
+    ASSERT_TRUE(vm.pin(buf, 16));
+    vm.unpin(buf, 16);
+
+    auto entry = vm.get_page_table()->lookup_entry(vaddr_to_vpn((Address)buf, page_size));
+    ASSERT_NE(entry, nullptr);
+    EXPECT_TRUE(entry->is_pinned);
+    EXPECT_EQ(entry->pin_count, 1);
+    EXPECT_EQ(vm.get_gpu_pages_pinned(), 1u);
+
+    vm.unpin(buf, 16);
+    EXPECT_FALSE(entry->is_pinned);
+    EXPECT_EQ(vm.get_gpu_pages_pinned(), 0u);
+
+    vm.free(buf);
+}
+
+TEST_F(PinningVMTest, PinnedFractionIsEnforced)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(6 * page_size);
+    ASSERT_NE(buf, nullptr);
+
+    EXPECT_FALSE(vm.pin(buf, 6 * page_size));
+    EXPECT_EQ(vm.get_gpu_pages_pinned(), 0u);
+
+    EXPECT_TRUE(vm.pin(buf, 4 * page_size));
+    EXPECT_FALSE(vm.pin(buf + 4 * page_size, page_size));
+    EXPECT_EQ(vm.get_gpu_pages_pinned(), 4u);
+
+    vm.free(buf);
+    EXPECT_EQ(vm.get_gpu_pages_pinned(), 0u);
+}
+
+TEST(LinkModelTest, LatencyPlusBandwidth)
+{
+    LinkModel link = LinkModel::pcie_gen4_x16();
+    EXPECT_EQ(link.transfer_time_ns(0, MigrationDirection::HOST_TO_DEVICE), link.h2d_latency_ns);
+    EXPECT_EQ(link.transfer_time_ns(25000, MigrationDirection::HOST_TO_DEVICE), link.h2d_latency_ns + 1000);
+    EXPECT_EQ(link.transfer_time_ns(26000, MigrationDirection::DEVICE_TO_HOST), link.d2h_latency_ns + 1000);
+
+    size_t bytes = 2 * 1024 * 1024;
+    EXPECT_LT(LinkModel::nvlink2().transfer_time_ns(bytes, MigrationDirection::HOST_TO_DEVICE),
+              LinkModel::pcie_gen3_x16().transfer_time_ns(bytes, MigrationDirection::HOST_TO_DEVICE));
+}
+
+class MigrationDataVMTest : public ManagedVMTest
+{
+protected:
+    void configure(VMConfig &config) override
+    {
+        config.gpu_memory = 2 * page_size;
+        config.cpu_memory = 16 * page_size;
+        config.link = LinkModel::nvlink2();
+    }
+};
+
+TEST_F(MigrationDataVMTest, MigrationCopiesPageContents)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(page_size);
+    ASSERT_NE(buf, nullptr);
+
+    std::vector<uint8_t> pattern(page_size);
+    for (size_t i = 0; i < page_size; i++)
+    {
+        pattern[i] = (uint8_t)(i * 7 + 3);
+    }
+    vm.write_to_vaddr(buf, pattern.data(), page_size);
+    vm.touch_page(buf);
+
+    ASSERT_TRUE(entry_of(buf)->resident_on_gpu);
+    uint8_t *device = device_copy(buf);
+    ASSERT_NE(device, nullptr);
+    EXPECT_EQ(std::memcmp(device, pattern.data(), page_size), 0);
+
+    auto *mm = vm.get_migration_manager();
+    EXPECT_EQ(mm->get_bytes_transferred(MigrationDirection::HOST_TO_DEVICE), page_size);
+    EXPECT_EQ(mm->get_modeled_time_ns(MigrationDirection::HOST_TO_DEVICE),
+              LinkModel::nvlink2().transfer_time_ns(page_size, MigrationDirection::HOST_TO_DEVICE));
+
+    vm.free(buf);
+}
+
+TEST_F(MigrationDataVMTest, DeviceWritesSurviveEviction)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(3 * page_size);
+    ASSERT_NE(buf, nullptr);
+
+    vm.touch_page(buf);
+    std::memset(device_copy(buf), 0xAB, page_size);
+    vm.touch_page(buf, true);
+
+    vm.touch_page(buf + page_size);
+    vm.touch_page(buf + 2 * page_size);
+    ASSERT_FALSE(entry_of(buf)->resident_on_gpu);
+
+    std::vector<uint8_t> out(page_size, 0);
+    vm.read_from_vaddr(buf, out.data(), page_size);
+    EXPECT_EQ(out[0], 0xAB);
+    EXPECT_EQ(out[page_size - 1], 0xAB);
+    EXPECT_GT(vm.get_migration_manager()->get_bytes_transferred(MigrationDirection::DEVICE_TO_HOST), 0u);
+
+    vm.free(buf);
+}
+
+TEST_F(MigrationDataVMTest, HostAccessStaysCoherentWithDevice)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(page_size);
+    ASSERT_NE(buf, nullptr);
+
+    vm.touch_page(buf);
+    std::memset(device_copy(buf), 0x5C, page_size);
+    vm.touch_page(buf, true);
+
+    uint8_t value = 0;
+    vm.read_from_vaddr(buf, &value, 1);
+    EXPECT_EQ(value, 0x5C);
+    EXPECT_FALSE(entry_of(buf)->resident_on_gpu);
+
+    vm.touch_page(buf);
+    EXPECT_EQ(device_copy(buf)[0], 0x5C);
+    EXPECT_FALSE(entry_of(buf)->gpu_dirty);
+
+    std::vector<uint8_t> fresh(page_size, 0x11);
+    vm.write_to_vaddr(buf, fresh.data(), page_size);
+    EXPECT_TRUE(entry_of(buf)->resident_on_gpu);
+    EXPECT_TRUE(entry_of(buf)->cpu_dirty);
+
+    vm.touch_page(buf);
+    ASSERT_TRUE(entry_of(buf)->resident_on_gpu);
+    EXPECT_FALSE(entry_of(buf)->cpu_dirty);
+    EXPECT_EQ(device_copy(buf)[0], 0x11);
+
+    vm.free(buf);
+}
+
+TEST_F(MigrationDataVMTest, FaultsAndWritebacksRunOnCopyEngines)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(4 * page_size);
+    ASSERT_NE(buf, nullptr);
+    std::vector<uint8_t> data(4 * page_size, 0x77);
+    vm.write_to_vaddr(buf, data.data(), data.size());
+
+    // Four dirty pages through two frames: fills and writebacks both.
+    for (size_t i = 0; i < 4; i++)
+    {
+        vm.touch_page(buf + i * page_size, true);
+    }
+
+    auto *mm = vm.get_migration_manager();
+    auto jobs = [mm](MigrationDirection dir)
+    {
+        uint64_t total = 0;
+        for (const auto &engine : mm->get_copy_engines(dir))
+        {
+            total += engine->get_jobs_completed();
+        }
+        return total;
+    };
+    EXPECT_EQ(jobs(MigrationDirection::HOST_TO_DEVICE), mm->get_transfers(MigrationDirection::HOST_TO_DEVICE));
+    EXPECT_EQ(jobs(MigrationDirection::DEVICE_TO_HOST), mm->get_transfers(MigrationDirection::DEVICE_TO_HOST));
+    EXPECT_GE(jobs(MigrationDirection::DEVICE_TO_HOST), 2u);
+    EXPECT_TRUE(entry_of(buf + 3 * page_size)->resident_on_gpu);
+
+    vm.free(buf);
+}
+
+TEST_F(MigrationDataVMTest, CleanEvictionSkipsWriteback)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(4 * page_size);
+    ASSERT_NE(buf, nullptr);
+    vm.reset_counters();
+
+    // Host writes before the page reaches the GPU do not make the device copy dirty.
+    std::vector<uint8_t> data(page_size, 0x42);
+    vm.write_to_vaddr(buf, data.data(), page_size);
+    for (size_t i = 0; i < 4; i++)
+    {
+        vm.touch_page(buf + i * page_size);
+    }
+
+    auto *mm = vm.get_migration_manager();
+    EXPECT_EQ(vm.get_perf_counters().evictions, 2u);
+    EXPECT_EQ(vm.get_perf_counters().clean_evictions, 2u);
+    EXPECT_EQ(mm->get_transfers(MigrationDirection::DEVICE_TO_HOST), 0u);
+
+    vm.free(buf);
+}
+
+TEST_F(MigrationDataVMTest, PreferCleanVictimsAvoidsWriteback)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    restart([](VMConfig &config)
+            { config.prefer_clean_victims = true; });
+
+    uint8_t *buf = (uint8_t *)vm.allocate(3 * page_size);
+    ASSERT_NE(buf, nullptr);
+    vm.reset_counters();
+
+    vm.touch_page(buf, true);
+    vm.touch_page(buf + page_size);
+    vm.touch_page(buf + 2 * page_size);
+
+    EXPECT_TRUE(entry_of(buf)->resident_on_gpu);
+    EXPECT_FALSE(entry_of(buf + page_size)->resident_on_gpu);
+    EXPECT_EQ(vm.get_perf_counters().clean_evictions, 1u);
+    EXPECT_EQ(vm.get_migration_manager()->get_transfers(MigrationDirection::DEVICE_TO_HOST), 0u);
+
+    vm.free(buf);
+}
+
+TEST_F(MigrationDataVMTest, DirtyGranulesLimitCopiesToModifiedBytes)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    restart([](VMConfig &config)
+            { config.dirty_granule_size = 512; });
+
+    uint8_t *buf = (uint8_t *)vm.allocate(page_size);
+    ASSERT_NE(buf, nullptr);
+    vm.touch_page(buf);
+    vm.reset_counters();
+    auto *mm = vm.get_migration_manager();
+    const auto h2d = MigrationDirection::HOST_TO_DEVICE;
+    const auto d2h = MigrationDirection::DEVICE_TO_HOST;
+    uint64_t h2d_before = mm->get_bytes_transferred(h2d);
+    // Delta copies run on the copy engines like full-page ones.
+    auto engine_jobs = [mm, h2d, d2h]()
+    {
+        uint64_t total = 0;
+        for (auto dir : {h2d, d2h})
+        {
+            for (const auto &engine : mm->get_copy_engines(dir))
+            {
+                total += engine->get_jobs_completed(MigrationPriority::DEMAND);
+            }
+        }
+        return total;
+    };
+    uint64_t jobs_before = engine_jobs();
+
+    std::vector<uint8_t> data(100, 0x77);
+    vm.write_to_vaddr(buf + 1024, data.data(), data.size());
+    EXPECT_EQ(entry_of(buf)->cpu_dirty_granules, 1u << 2);
+
+    vm.touch_page(buf);
+    EXPECT_EQ(device_copy(buf)[1024], 0x77);
+    EXPECT_EQ(mm->get_bytes_transferred(h2d) - h2d_before, 512u);
+
+    std::memset(device_copy(buf) + 3072, 0x99, 512);
+    vm.touch_page(buf + 3072, true);
+    EXPECT_EQ(entry_of(buf)->gpu_dirty_granules, 1u << 6);
+
+    uint8_t value = 0;
+    vm.read_from_vaddr(buf + 3072, &value, 1);
+    EXPECT_EQ(value, 0x99);
+    EXPECT_EQ(mm->get_bytes_transferred(d2h), 512u);
+
+    const auto &perf = vm.get_perf_counters();
+    EXPECT_EQ(perf.delta_migrations, 2u);
+    EXPECT_EQ(perf.delta_bytes_saved, 2 * (page_size - 512));
+    EXPECT_EQ(engine_jobs() - jobs_before, 2u);
+
+    vm.free(buf);
+}
+
+TEST_F(MigrationDataVMTest, ZeroPagesAreBackedOnFirstWrite)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    restart([this](VMConfig &config)
+            {
+                config.gpu_memory = 4 * page_size;
+                config.zero_fill_on_demand = true;
+            });
+
+    auto *allocator = vm.get_allocator();
+    auto *mm = vm.get_migration_manager();
+    size_t free_cpu = allocator->get_available_cpu_pages();
+    uint8_t *buf = (uint8_t *)vm.allocate(3 * page_size);
+    ASSERT_NE(buf, nullptr);
+    vm.reset_counters();
+    EXPECT_EQ(allocator->get_available_cpu_pages(), free_cpu);
+
+    uint8_t value = 0xFF;
+    vm.read_from_vaddr(buf + 100, &value, 1);
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(entry_of(buf)->is_zero);
+    EXPECT_EQ(allocator->get_available_cpu_pages(), free_cpu);
+
+    // The first GPU touch zero-fills the frame instead of copying over the link.
+    vm.touch_page(buf + page_size);
+    ASSERT_TRUE(entry_of(buf + page_size)->resident_on_gpu);
+    EXPECT_EQ(device_copy(buf + page_size)[0], 0);
+    EXPECT_EQ(mm->get_transfers(MigrationDirection::HOST_TO_DEVICE), 0u);
+    EXPECT_EQ(vm.get_perf_counters().zero_page_fills, 1u);
+
+    std::vector<uint8_t> data(16, 0x5A);
+    vm.write_to_vaddr(buf, data.data(), data.size());
+    EXPECT_FALSE(entry_of(buf)->is_zero);
+    EXPECT_EQ(allocator->get_available_cpu_pages(), free_cpu - 1);
+    vm.read_from_vaddr(buf + 15, &value, 1);
+    EXPECT_EQ(value, 0x5A);
+
+    // Device writes get a host frame only when they leave non-zero data.
+    std::memset(device_copy(buf + page_size), 0x3C, page_size);
+    vm.touch_page(buf + page_size, true);
+    vm.read_from_vaddr(buf + page_size, &value, 1);
+    EXPECT_EQ(value, 0x3C);
+    EXPECT_EQ(mm->get_transfers(MigrationDirection::DEVICE_TO_HOST), 1u);
+
+    vm.touch_page(buf + 2 * page_size, true);
+    vm.read_from_vaddr(buf + 2 * page_size, &value, 1);
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(entry_of(buf + 2 * page_size)->is_zero);
+    EXPECT_EQ(vm.get_perf_counters().zero_page_elisions, 1u);
+    EXPECT_EQ(mm->get_transfers(MigrationDirection::DEVICE_TO_HOST), 1u);
+
+    vm.free(buf);
+    EXPECT_EQ(allocator->get_available_cpu_pages(), free_cpu);
+}
+
+TEST_F(MigrationDataVMTest, PagesArePopulatedOnFirstTouch)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    auto *allocator = vm.get_allocator();
+    auto *page_table = vm.get_page_table();
+    size_t free_cpu = allocator->get_available_cpu_pages();
+    size_t entries = page_table->get_num_populated_pages();
+
+    // The reservation may exceed host memory; nothing is backed until touched.
+    uint8_t *buf = (uint8_t *)vm.allocate(64 * page_size);
+    ASSERT_NE(buf, nullptr);
+    vm.reset_counters();
+    EXPECT_EQ(allocator->get_available_cpu_pages(), free_cpu);
+    EXPECT_EQ(page_table->get_num_populated_pages(), entries);
+
+    // A GPU first touch places the page on the device with no host frame.
+    vm.touch_page(buf + 40 * page_size);
+    EXPECT_TRUE(entry_of(buf + 40 * page_size)->resident_on_gpu);
+    EXPECT_EQ(allocator->get_available_cpu_pages(), free_cpu);
+    EXPECT_EQ(vm.get_migration_manager()->get_transfers(MigrationDirection::HOST_TO_DEVICE), 0u);
+
+    // A host first touch places it on the host.
+    uint8_t value = 0xFF;
+    vm.read_from_vaddr(buf + 3 * page_size, &value, 1);
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(entry_of(buf + 3 * page_size)->resident_on_cpu);
+    EXPECT_EQ(allocator->get_available_cpu_pages(), free_cpu - 1);
+    EXPECT_EQ(page_table->get_num_populated_pages(), entries + 2);
+
+    vm.free(buf);
+    EXPECT_EQ(allocator->get_available_cpu_pages(), free_cpu);
+    EXPECT_EQ(page_table->get_num_populated_pages(), entries);
+}
+
+TEST_F(MigrationDataVMTest, RangePrefetchIssuesOneCopy)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(2 * page_size);
+    ASSERT_NE(buf, nullptr);
+    std::vector<uint8_t> data(page_size, 0x11);
+    vm.write_to_vaddr(buf, data.data(), page_size);
+    vm.write_to_vaddr(buf + page_size, data.data(), page_size);
+    vm.reset_counters();
+
+    vm.prefetch_to_gpu(buf, 2 * page_size);
+    EXPECT_TRUE(entry_of(buf)->resident_on_gpu);
+    EXPECT_TRUE(entry_of(buf + page_size)->resident_on_gpu);
+
+    const auto &perf = vm.get_perf_counters();
+    EXPECT_EQ(perf.page_prefetches, 2u);
+    EXPECT_EQ(perf.cpu_to_gpu_migrations, 2u);
+    EXPECT_EQ(perf.migration_batches, 1u);
+    EXPECT_EQ(perf.migration_batch_copies, 1u);
+
+    vm.free(buf);
+}
+
+TEST_F(MigrationDataVMTest, HostCopiesSpanPages)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(4 * page_size);
+    uint8_t *next = (uint8_t *)vm.allocate(page_size);
+    ASSERT_NE(buf, nullptr);
+    ASSERT_NE(next, nullptr);
+    uint8_t sentinel = 0xEE;
+    vm.write_to_vaddr(next, &sentinel, 1);
+
+    std::vector<uint8_t> data(3 * page_size + 500);
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = (uint8_t)(i * 7 + 3);
+    }
+    vm.write_to_vaddr(buf + 100, data.data(), data.size());
+
+    std::vector<uint8_t> out(data.size(), 0);
+    vm.read_from_vaddr(buf + 100, out.data(), out.size());
+    EXPECT_EQ(out, data);
+
+    uint8_t value = 0;
+    vm.read_from_vaddr(buf + 2 * page_size, &value, 1);
+    EXPECT_EQ(value, data[2 * page_size - 100]);
+    vm.read_from_vaddr(next, &value, 1);
+    EXPECT_EQ(value, 0xEE);
+
+    vm.free(next);
+    vm.free(buf);
+}
+
+TEST_F(MigrationDataVMTest, HostCopiesFetchDeviceDataInOneBatch)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(2 * page_size);
+    ASSERT_NE(buf, nullptr);
+    std::vector<uint8_t> data(2 * page_size, 0x10);
+    vm.write_to_vaddr(buf, data.data(), data.size());
+    for (size_t i = 0; i < 2; i++)
+    {
+        vm.touch_page(buf + i * page_size);
+        std::memset(device_copy(buf + i * page_size), 0x20 + (int)i, page_size);
+        vm.touch_page(buf + i * page_size, true);
+    }
+    vm.reset_counters();
+    auto *mm = vm.get_migration_manager();
+    const auto d2h = MigrationDirection::DEVICE_TO_HOST;
+    uint64_t d2h_before = mm->get_transfers(d2h);
+
+    std::vector<uint8_t> out(2, 0);
+    vm.read_from_vaddr(buf + page_size - 1, out.data(), out.size());
+    EXPECT_EQ(out.front(), 0x20);
+    EXPECT_EQ(out.back(), 0x21);
+    EXPECT_EQ(vm.get_perf_counters().gpu_to_cpu_migrations, 2u);
+    EXPECT_EQ(vm.get_perf_counters().migration_batches, 1u);
+
+    // A write covering a whole page does not fetch the device copy first.
+    vm.touch_page(buf);
+    d2h_before = mm->get_transfers(d2h);
+    std::memset(device_copy(buf), 0x30, page_size);
+    vm.touch_page(buf, true);
+    vm.write_to_vaddr(buf, data.data(), page_size);
+    EXPECT_EQ(mm->get_transfers(d2h), d2h_before);
+    vm.touch_page(buf);
+    EXPECT_EQ(device_copy(buf)[page_size - 1], 0x10);
+
+    vm.free(buf);
+}
+
+TEST_F(MigrationDataVMTest, StreamingCopiesMatchUnalignedRanges)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    restart([](VMConfig &config)
+            { config.streaming_copy_threshold = 1; });
+
+    uint8_t *buf = (uint8_t *)vm.allocate(3 * page_size);
+    ASSERT_NE(buf, nullptr);
+    std::vector<uint8_t> data(2 * page_size + 77);
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = (uint8_t)(i ^ (i >> 8));
+    }
+    vm.write_to_vaddr(buf + 13, data.data(), data.size());
+
+    std::vector<uint8_t> out(data.size() + 1, 0);
+    vm.read_from_vaddr(buf + 13, out.data() + 1, data.size());
+    EXPECT_TRUE(std::equal(data.begin(), data.end(), out.begin() + 1));
+
+    vm.free(buf);
+}
+
+TEST_F(MigrationDataVMTest, PrefetchRangeMigratesAsynchronously)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(2 * page_size);
+    ASSERT_NE(buf, nullptr);
+    std::vector<uint8_t> data(2 * page_size, 0x12);
+    vm.write_to_vaddr(buf, data.data(), data.size());
+    vm.reset_counters();
+
+    Stream stream;
+    Event to_gpu = vm.prefetch_range(buf, 2 * page_size, Location::GPU, &stream);
+    to_gpu.synchronize();
+    EXPECT_TRUE(entry_of(buf)->resident_on_gpu);
+    EXPECT_TRUE(entry_of(buf + page_size)->resident_on_gpu);
+    const auto &perf = vm.get_perf_counters();
+    EXPECT_EQ(perf.cpu_to_gpu_migrations, 2u);
+    EXPECT_EQ(perf.migration_batches, 1u);
+
+    // Moving back copies only what the device changed and frees its frames.
+    std::memset(device_copy(buf), 0x34, page_size);
+    vm.touch_page(buf, true);
+    Event to_cpu = vm.prefetch_range(buf, 2 * page_size, Location::CPU);
+    to_cpu.synchronize();
+    EXPECT_TRUE(to_cpu.query());
+    EXPECT_FALSE(entry_of(buf)->resident_on_gpu);
+    EXPECT_FALSE(entry_of(buf + page_size)->resident_on_gpu);
+    EXPECT_EQ(vm.get_gpu_pages_available(), 2u);
+    EXPECT_EQ(perf.gpu_to_cpu_migrations, 1u);
+    EXPECT_EQ(perf.page_prefetches, 4u);
+
+    uint8_t value = 0;
+    vm.read_from_vaddr(buf + 10, &value, 1);
+    EXPECT_EQ(value, 0x34);
+    vm.read_from_vaddr(buf + page_size, &value, 1);
+    EXPECT_EQ(value, 0x12);
+
+    vm.free(buf);
+}
+
+TEST_F(MigrationDataVMTest, SyncAllMigrationsWaitsForPrefetchStreams)
+{
+    restart([this](VMConfig &config)
+            {
+        config.gpu_memory = 256 * page_size;
+        config.cpu_memory = 512 * page_size; });
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(128 * page_size);
+    ASSERT_NE(buf, nullptr);
+    uint8_t *other = (uint8_t *)vm.allocate(128 * page_size);
+    ASSERT_NE(other, nullptr);
+
+    Stream stream;
+    vm.prefetch_range(buf, 128 * page_size, Location::GPU);
+    vm.prefetch_range(other, 128 * page_size, Location::GPU, &stream);
+    vm.sync_all_migrations();
+
+    for (size_t i = 0; i < 128; i++)
+    {
+        EXPECT_TRUE(on_gpu(buf + i * page_size));
+        EXPECT_TRUE(on_gpu(other + i * page_size));
+    }
+
+    vm.free(buf);
+    vm.free(other);
+}
+
+TEST_F(MigrationDataVMTest, ReadMostlyKeepsDuplicatesUntilWritten)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(page_size);
+    ASSERT_NE(buf, nullptr);
+    std::vector<uint8_t> data(page_size, 0x5C);
+    vm.write_to_vaddr(buf, data.data(), page_size);
+    vm.advise(buf, page_size, Advice::SET_READ_MOSTLY);
+    EXPECT_EQ(vm.get_residency(buf), PageResidency::CPU_ONLY);
+
+    vm.touch_page(buf);
+    uint8_t value = 0;
+    vm.read_from_vaddr(buf, &value, 1);
+    EXPECT_EQ(value, 0x5C);
+    EXPECT_EQ(vm.get_residency(buf), PageResidency::BOTH);
+
+    // A host write invalidates the device duplicate instead of leaving it stale.
+    value = 0x6D;
+    vm.write_to_vaddr(buf, &value, 1);
+    EXPECT_EQ(vm.get_residency(buf), PageResidency::CPU_ONLY);
+    EXPECT_EQ(vm.get_gpu_pages_available(), 2u);
+
+    vm.touch_page(buf);
+    EXPECT_EQ(device_copy(buf)[0], 0x6D);
+    EXPECT_EQ(vm.get_residency(buf), PageResidency::BOTH);
+
+    vm.free(buf);
+    EXPECT_EQ(vm.get_residency(buf), PageResidency::UNALLOCATED);
+}
+
+TEST_F(MigrationDataVMTest, ReadMostlyDuplicatesWhereDefaultMigrates)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *plain = (uint8_t *)vm.allocate(page_size);
+    uint8_t *shared = (uint8_t *)vm.allocate(page_size);
+    ASSERT_NE(plain, nullptr);
+    ASSERT_NE(shared, nullptr);
+    std::vector<uint8_t> data(page_size, 0x3E);
+    vm.write_to_vaddr(plain, data.data(), page_size);
+    vm.write_to_vaddr(shared, data.data(), page_size);
+    vm.advise(shared, page_size, Advice::SET_READ_MOSTLY);
+    vm.reset_counters();
+
+    // Reads alternating between the GPU and the host.
+    uint8_t value = 0;
+    for (int round = 0; round < 3; round++)
+    {
+        vm.touch_page(plain);
+        vm.read_from_vaddr(plain, &value, 1);
+        EXPECT_EQ(value, 0x3E);
+    }
+    EXPECT_EQ(vm.get_residency(plain), PageResidency::CPU_ONLY);
+    EXPECT_EQ(vm.get_perf_counters().cpu_to_gpu_migrations, 3u);
+
+    vm.reset_counters();
+    for (int round = 0; round < 3; round++)
+    {
+        vm.touch_page(shared);
+        vm.read_from_vaddr(shared, &value, 1);
+        EXPECT_EQ(value, 0x3E);
+    }
+    EXPECT_EQ(vm.get_residency(shared), PageResidency::BOTH);
+    EXPECT_EQ(vm.get_perf_counters().cpu_to_gpu_migrations, 1u);
+    EXPECT_EQ(vm.get_perf_counters().total_page_faults, 1u);
+
+    vm.free(plain);
+    vm.free(shared);
+}
+
+TEST_F(MigrationDataVMTest, PreferredLocationAndAccessedByBiasPlacement)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(5 * page_size);
+    ASSERT_NE(buf, nullptr);
+    std::vector<uint8_t> data(5 * page_size, 0x01);
+    vm.write_to_vaddr(buf, data.data(), data.size());
+    vm.reset_counters();
+
+    // The coldest page stays because it prefers the GPU.
+    vm.advise(buf, page_size, Advice::SET_PREFERRED_LOCATION, Location::GPU);
+    vm.touch_page(buf);
+    vm.touch_page(buf + page_size);
+    vm.touch_page(buf + 2 * page_size);
+    EXPECT_TRUE(entry_of(buf)->resident_on_gpu);
+    EXPECT_FALSE(entry_of(buf + page_size)->resident_on_gpu);
+
+    // GPU accesses to host-preferred or GPU-mapped pages do not migrate them.
+    auto *mm = vm.get_migration_manager();
+    uint64_t h2d = mm->get_transfers(MigrationDirection::HOST_TO_DEVICE);
+    uint64_t faults = vm.get_perf_counters().total_page_faults;
+    vm.advise(buf + 3 * page_size, page_size, Advice::SET_PREFERRED_LOCATION, Location::CPU);
+    vm.advise(buf + 4 * page_size, page_size, Advice::SET_ACCESSED_BY, Location::GPU);
+    vm.touch_page(buf + 3 * page_size);
+    vm.touch_page(buf + 4 * page_size);
+    EXPECT_FALSE(entry_of(buf + 3 * page_size)->resident_on_gpu);
+    EXPECT_FALSE(entry_of(buf + 4 * page_size)->resident_on_gpu);
+    EXPECT_EQ(mm->get_transfers(MigrationDirection::HOST_TO_DEVICE), h2d);
+    EXPECT_EQ(vm.get_perf_counters().total_page_faults, faults + 1);
+    EXPECT_EQ(vm.get_perf_counters().remote_accesses, 2u);
+
+    // An explicit prefetch still moves a host-preferred page.
+    vm.prefetch_to_gpu(buf + 3 * page_size);
+    EXPECT_TRUE(entry_of(buf + 3 * page_size)->resident_on_gpu);
+
+    vm.free(buf);
+}
+
+TEST_F(MigrationDataVMTest, ConcurrentFaultsOnDisjointPagesStayCoherent)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    const size_t threads_count = 4;
+    const size_t pages_per_thread = 2;
+    uint8_t *buf = (uint8_t *)vm.allocate(threads_count * pages_per_thread * page_size);
+    ASSERT_NE(buf, nullptr);
+    vm.reset_counters();
+
+    // Eight pages contend for two GPU frames, so threads evict each other's pages.
+    std::atomic<size_t> mismatches{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threads_count; t++)
+    {
+        threads.emplace_back([&, t]()
+                             {
+            for (uint32_t iter = 0; iter < 200; iter++)
+            {
+                uint8_t *page = buf + (t * pages_per_thread + iter % pages_per_thread) * page_size;
+                uint32_t value = (uint32_t)(t << 24) | iter;
+                vm.write_to_vaddr(page, &value, sizeof(value));
+                uint32_t out = 0;
+                vm.read_from_vaddr(page, &out, sizeof(out));
+                if (out != value)
+                {
+                    mismatches++;
+                }
+                // Host reads migrate pages back, so fault after them to keep frames contended.
+                vm.touch_page(page, true);
+            } });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    EXPECT_EQ(mismatches.load(), 0u);
+    EXPECT_GT(vm.get_perf_counters().evictions, 0u);
+    EXPECT_LE(vm.get_gpu_pages_used(), 2u);
+    EXPECT_EQ(vm.get_gpu_pages_used() + vm.get_gpu_pages_available(), 2u);
+
+    vm.free(buf);
+    EXPECT_EQ(vm.get_gpu_pages_available(), 2u);
+}
+
+TEST_F(MigrationDataVMTest, ConcurrentFaultsOnOnePageMigrateItOnce)
+{
+    const size_t pages = 16;
+    for (bool fault_buffer : {false, true})
+    {
+        restart([&](VMConfig &config)
+                {
+            config.gpu_memory = 2 * pages * page_size;
+            config.cpu_memory = 4 * pages * page_size;
+            config.enable_fault_buffer = fault_buffer; });
+        auto &vm = VirtualMemoryManager::instance();
+        uint8_t *buf = (uint8_t *)vm.allocate(pages * page_size);
+        ASSERT_NE(buf, nullptr);
+        std::vector<uint8_t> data(pages * page_size, 0x6A);
+        vm.write_to_vaddr(buf, data.data(), data.size());
+        vm.reset_counters();
+
+        // Both threads fault every page in the same order, released together.
+        std::atomic<int> ready{0};
+        auto fault_all = [&]()
+        {
+            ready++;
+            while (ready.load() < 2)
+            {
+                std::this_thread::yield();
+            }
+            for (size_t i = 0; i < pages; i++)
+            {
+                vm.touch_page(buf + i * page_size);
+            }
+        };
+        std::thread first(fault_all);
+        std::thread second(fault_all);
+        first.join();
+        second.join();
+
+        EXPECT_EQ(vm.get_gpu_pages_used(), pages) << "fault_buffer=" << fault_buffer;
+        EXPECT_EQ(vm.get_perf_counters().cpu_to_gpu_migrations, pages) << "fault_buffer=" << fault_buffer;
+        EXPECT_EQ(vm.get_migration_manager()->get_transfers(MigrationDirection::HOST_TO_DEVICE), pages);
+        for (size_t i = 0; i < pages; i++)
+        {
+            ASSERT_TRUE(on_gpu(buf + i * page_size));
+            EXPECT_EQ(device_copy(buf + i * page_size)[0], 0x6A);
+        }
+        vm.free(buf);
+    }
+}
+
+TEST_F(MigrationDataVMTest, FaultsOnPagesBeingPrefetchedWaitForTheCopy)
+{
+    const size_t pages = 128;
+    restart([&](VMConfig &config)
+            {
+        config.gpu_memory = 2 * pages * page_size;
+        config.cpu_memory = 4 * pages * page_size; });
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(pages * page_size);
+    ASSERT_NE(buf, nullptr);
+    std::vector<uint8_t> data(pages * page_size, 0x1F);
+    vm.write_to_vaddr(buf, data.data(), data.size());
+    vm.reset_counters();
+
+    // The prefetch and the faults race over the same pages; each page moves once.
+    Stream stream;
+    vm.prefetch_range(buf, pages * page_size, Location::GPU, &stream);
+    for (size_t i = pages; i-- > 0;)
+    {
+        vm.touch_page(buf + i * page_size);
+    }
+    stream.synchronize();
+
+    const auto &perf = vm.get_perf_counters();
+    EXPECT_EQ(vm.get_gpu_pages_used(), pages);
+    EXPECT_EQ(perf.cpu_to_gpu_migrations, pages);
+    for (size_t i = 0; i < pages; i++)
+    {
+        ASSERT_TRUE(on_gpu(buf + i * page_size));
+        EXPECT_EQ(device_copy(buf + i * page_size)[page_size - 1], 0x1F);
+    }
+
+    vm.free(buf);
+}
+
+class BackgroundEvictionVMTest : public ManagedVMTest
+{
+protected:
+    void configure(VMConfig &config) override
+    {
+        config.gpu_memory = 8 * page_size;
+        config.cpu_memory = 16 * page_size;
+        config.enable_background_eviction = true;
+        config.background_eviction.low_watermark = 0.25;
+        config.background_eviction.high_watermark = 0.5;
+    }
+};
+
+TEST_F(BackgroundEvictionVMTest, DaemonRestoresHighWatermarkAheadOfFaults)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(12 * page_size);
+    ASSERT_NE(buf, nullptr);
+    vm.reset_counters();
+    auto *daemon = vm.get_eviction_daemon();
+    ASSERT_NE(daemon, nullptr);
+    EXPECT_EQ(daemon->get_low_watermark_pages(), 2u);
+    EXPECT_EQ(daemon->get_high_watermark_pages(), 4u);
+
+    auto *page_table = vm.get_page_table();
+    VirtualPageNumber first = vaddr_to_vpn((Address)buf, page_size);
+    vm.touch_page(buf);
+    std::memset(vm.get_allocator()->gpu_page_ptr(page_table->lookup_entry(first)->gpu_address), 0xCD, page_size);
+    vm.touch_page(buf, true);
+
+    // Dropping to one free frame wakes the daemon.
+    for (size_t i = 1; i < 7; i++)
+    {
+        vm.touch_page(buf + i * page_size);
+    }
+    for (int i = 0; i < 2000 && vm.get_gpu_pages_available() < 4; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_GE(vm.get_gpu_pages_available(), 4u);
+
+    const auto &perf = vm.get_perf_counters();
+    EXPECT_GE(perf.background_evictions, 3u);
+    EXPECT_EQ(perf.direct_evictions, 0u);
+    EXPECT_FALSE(page_table->lookup_entry(first)->resident_on_gpu);
+
+    // The dirty device copy was written back before its frame was reclaimed.
+    std::vector<uint8_t> out(page_size, 0);
+    vm.read_from_vaddr(buf, out.data(), page_size);
+    EXPECT_EQ(out[0], 0xCD);
+    EXPECT_EQ(out[page_size - 1], 0xCD);
+
+    vm.touch_page(buf + 7 * page_size);
+    EXPECT_EQ(perf.direct_evictions, 0u);
+
+    vm.free(buf);
+}
+
+TEST_F(BackgroundEvictionVMTest, PrefetchesAndWritebacksKeepTheirPriorities)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(8 * page_size);
+    ASSERT_NE(buf, nullptr);
+    std::vector<uint8_t> data(8 * page_size, 0x3B);
+    vm.write_to_vaddr(buf, data.data(), data.size());
+
+    auto *mm = vm.get_migration_manager();
+    auto jobs = [mm](MigrationDirection dir, MigrationPriority priority)
+    {
+        uint64_t total = 0;
+        for (const auto &engine : mm->get_copy_engines(dir))
+        {
+            total += engine->get_jobs_completed(priority);
+        }
+        return total;
+    };
+
+    vm.prefetch_range(buf, 7 * page_size, Location::GPU);
+    vm.sync_all_migrations();
+    EXPECT_GE(jobs(MigrationDirection::HOST_TO_DEVICE, MigrationPriority::PREFETCH), 1u);
+    EXPECT_EQ(jobs(MigrationDirection::HOST_TO_DEVICE, MigrationPriority::DEMAND), 0u);
+
+    // Dirty the prefetched pages; the daemon writes them back to restore the watermark.
+    for (size_t i = 0; i < 7; i++)
+    {
+        vm.touch_page(buf + i * page_size, true);
+    }
+    vm.get_eviction_daemon()->wake();
+    for (int i = 0; i < 2000 && vm.get_gpu_pages_available() < 4; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_GE(vm.get_gpu_pages_available(), 4u);
+    EXPECT_GE(jobs(MigrationDirection::DEVICE_TO_HOST, MigrationPriority::WRITEBACK), 1u);
+    EXPECT_EQ(jobs(MigrationDirection::DEVICE_TO_HOST, MigrationPriority::DEMAND), 0u);
+
+    std::vector<uint8_t> out(data.size(), 0);
+    vm.read_from_vaddr(buf, out.data(), out.size());
+    EXPECT_EQ(out, data);
+
+    vm.free(buf);
+}
+
+class StridePrefetchVMTest : public ManagedVMTest
+{
+protected:
+    void configure(VMConfig &config) override
+    {
+        config.gpu_memory = 64 * page_size;
+        config.cpu_memory = 64 * page_size;
+        config.enable_prefetch = true;
+    }
+};
+
+TEST_F(StridePrefetchVMTest, SequentialFaultsArePrefetched)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    const size_t num_pages = 48;
+    uint8_t *buf = (uint8_t *)vm.allocate(num_pages * page_size);
+    ASSERT_NE(buf, nullptr);
+    vm.reset_counters();
+
+    for (size_t i = 0; i < num_pages; i++)
+    {
+        vm.touch_page(buf + i * page_size);
+        vm.get_default_stream()->synchronize();
+    }
+
+    // Three faults confirm the stream; the rest find their pages resident.
+    const auto &perf = vm.get_perf_counters();
+    EXPECT_EQ(perf.total_page_faults, 3u);
+    EXPECT_EQ(perf.page_prefetches, num_pages - 3);
+    auto *prefetcher = vm.get_stride_prefetcher();
+    ASSERT_NE(prefetcher, nullptr);
+    EXPECT_EQ(prefetcher->get_useful(), num_pages - 3);
+    EXPECT_EQ(prefetcher->get_wasted(), 0u);
+
+    vm.free(buf);
+}
+
+class TreePrefetchVMTest : public ManagedVMTest
+{
+protected:
+    void configure(VMConfig &config) override
+    {
+        config.gpu_memory = 64 * page_size;
+        config.cpu_memory = 64 * page_size;
+        config.enable_tree_prefetch = true;
+        config.tree_prefetch.region_bytes = 16 * page_size;
+    }
+};
+
+TEST_F(TreePrefetchVMTest, ClusteredFaultsPromoteSubtrees)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(32 * page_size);
+    ASSERT_NE(buf, nullptr);
+    VirtualPageNumber first = vaddr_to_vpn((Address)buf, page_size);
+    uint8_t *region = buf + ((16 - first % 16) % 16) * page_size;
+    vm.reset_counters();
+
+    auto touch = [&](size_t page)
+    {
+        vm.touch_page(region + page * page_size);
+        vm.get_default_stream()->synchronize();
+    };
+    touch(0);
+    touch(2);
+    touch(1); // [0, 4) is 3/4 dense: page 3 follows
+    touch(4); // [0, 8) is 5/8 dense: pages 5-7 follow
+
+    auto *page_table = vm.get_page_table();
+    VirtualPageNumber base = vaddr_to_vpn((Address)region, page_size);
+    for (size_t page = 0; page < 8; page++)
+    {
+        EXPECT_TRUE(page_table->lookup_entry(base + page)->resident_on_gpu) << page;
+    }
+    EXPECT_FALSE(page_table->lookup_entry(base + 8)->resident_on_gpu);
+
+    auto *prefetcher = vm.get_tree_prefetcher();
+    ASSERT_NE(prefetcher, nullptr);
+    EXPECT_EQ(prefetcher->get_promotions(2), 1u);
+    EXPECT_EQ(prefetcher->get_promotions(3), 1u);
+    const auto &perf = vm.get_perf_counters();
+    EXPECT_EQ(perf.total_page_faults, 4u);
+    EXPECT_EQ(perf.page_prefetches, 4u);
+
+    vm.free(buf);
+}
+
+TEST_F(TreePrefetchVMTest, LargePromotionsMoveInChunks)
+{
+    restart([this](VMConfig &config)
+            {
+        config.gpu_memory = 1024 * page_size;
+        config.cpu_memory = 1024 * page_size;
+        config.tree_prefetch.region_bytes = 256 * page_size; });
+    auto &vm = VirtualMemoryManager::instance();
+    uint8_t *buf = (uint8_t *)vm.allocate(512 * page_size);
+    ASSERT_NE(buf, nullptr);
+    std::vector<uint8_t> data(512 * page_size, 0x5a);
+    vm.write_to_vaddr(buf, data.data(), data.size());
+    VirtualPageNumber first = vaddr_to_vpn((Address)buf, page_size);
+    uint8_t *region = buf + ((256 - first % 256) % 256) * page_size;
+
+    auto touch = [&](size_t page)
+    {
+        vm.touch_page(region + page * page_size);
+        vm.get_default_stream()->synchronize();
+    };
+    for (size_t page : {0, 1, 2, 4, 8, 16, 32, 64})
+    {
+        touch(page);
+    }
+    vm.reset_counters();
+    touch(128); // [0, 256) is 129/256 dense: pages 129-255 follow
+
+    const auto &perf = vm.get_perf_counters();
+    EXPECT_EQ(perf.page_prefetches, 127u);
+    EXPECT_EQ(vm.get_tree_prefetcher()->get_promotions(8), 1u);
+    // Chunks [128, 192) and [192, 256), each copied under its own page locks.
+    EXPECT_EQ(perf.migration_batches, 2u);
+
+    vm.free(buf);
+}
+
+class FaultBufferVMTest : public ManagedVMTest
+{
+protected:
+    void configure(VMConfig &config) override
+    {
+        config.gpu_memory = 64 * page_size;
+        config.cpu_memory = 64 * page_size;
+        config.enable_fault_buffer = true;
+        config.fault_buffer.batch_size = 4;
+        config.fault_buffer.batch_window_us = 1000000;
+    }
+};
+
+TEST_F(FaultBufferVMTest, ConcurrentFaultsAreServicedInBatches)
+{
+    auto &vm = VirtualMemoryManager::instance();
+    const size_t num_pages = 16;
+    uint8_t *buf = (uint8_t *)vm.allocate(num_pages * page_size);
+    ASSERT_NE(buf, nullptr);
+    for (size_t page = 0; page < num_pages; page++)
+    {
+        std::vector<uint8_t> data(page_size, (uint8_t)(page + 1));
+        vm.write_to_vaddr(buf + page * page_size, data.data(), page_size);
+    }
+    vm.reset_counters();
+
+    // Each round, the four threads fault on four consecutive pages together.
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&, t]()
+                             {
+            for (size_t page = t; page < num_pages; page += 4)
+            {
+                vm.touch_page(buf + page * page_size);
+            } });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    auto *page_table = vm.get_page_table();
+    VirtualPageNumber first = vaddr_to_vpn((Address)buf, page_size);
+    for (size_t page = 0; page < num_pages; page++)
+    {
+        auto entry = page_table->lookup_entry(first + page);
+        ASSERT_TRUE(entry->resident_on_gpu) << page;
+        EXPECT_EQ(vm.get_allocator()->gpu_page_ptr(entry->gpu_address)[page_size - 1], page + 1);
+    }
+
+    auto *buffer = vm.get_fault_buffer();
+    ASSERT_NE(buffer, nullptr);
+    EXPECT_EQ(buffer->get_faults(), num_pages);
+    EXPECT_EQ(buffer->get_batches(), 4u);
+    const auto &perf = vm.get_perf_counters();
+    EXPECT_EQ(perf.total_page_faults, num_pages);
+    EXPECT_EQ(perf.cpu_to_gpu_migrations, num_pages);
+    EXPECT_EQ(perf.migration_batches, 4u);
+
+    vm.free(buf);
 }
 
 int main(int argc, char **argv)